@@ -1,5 +1,7 @@
+#include <charconv>
 #include <iostream>
 #include <string>
+#include <unordered_map>
 #include <stdlib.h>
 #include "ast.h"
 
@@ -40,17 +42,97 @@ const char* getStringNodeType(NodeType type) {
             return "create_table";
         case DROP_TABLE_NODE:
             return "drop_table";
+        case CONDITION_IN_NODE:
+            return "condition_in";
+        case CREATE_INDEX_NODE:
+            return "create_index";
+        case LIMIT_NODE:
+            return "limit";
+        case SORT_NODE:
+            return "sort";
+        case COLLECT_NODE:
+            return "collect";
         default:
             return "unknown";
     }
 }
 
+const char* getStringJoinStrategy(JoinStrategy strategy) {
+    switch (strategy) {
+        case NESTED_LOOP_JOIN:
+            return "nested_loop";
+        case HASH_JOIN:
+            return "hash";
+        case INDEX_NESTED_LOOP_JOIN:
+            return "index_nested_loop";
+        case SORT_MERGE_JOIN:
+            return "sort_merge";
+        default:
+            return "unknown";
+    }
+}
+
+const char* getStringSortAlgorithm(SortAlgorithm algorithm) {
+    switch (algorithm) {
+        case COMPARISON_SORT:
+            return "comparison";
+        case RADIX_SORT:
+            return "radix";
+        case TOP_K_SORT:
+            return "top_k";
+        default:
+            return "unknown";
+    }
+}
+
+const char* getStringAggregationAlgorithm(AggregationAlgorithm algorithm) {
+    switch (algorithm) {
+        case HASH_AGGREGATION:
+            return "hash";
+        case SORTED_AGGREGATION:
+            return "sorted";
+        case SCALAR_AGGREGATION:
+            return "scalar";
+        default:
+            return "unknown";
+    }
+}
+
+const char* getStringAggregateFunction(AggregateFunction function) {
+    switch (function) {
+        case COUNT:
+            return "count";
+        case SUM:
+            return "sum";
+        case MIN:
+            return "min";
+        case MAX:
+            return "max";
+        case AVG:
+            return "avg";
+        default:
+            return "unknown";
+    }
+}
+
+static std::string joinFields(const std::set<std::string>& fields) {
+    std::string joined;
+    for (auto field : fields) {
+        joined += (joined.empty() ? "" : ", ") + field;
+    }
+    return joined;
+}
+
 // ------------------------------------------ ForNode ------------------------------------------
 
 ForNode::ForNode(const char* variable, const char* tableName, Node* action) {
     this->variable = variable;
     this->tableName = tableName;
     this->action = action;
+    this->stopAfter = -1;
+    this->wholeDocument = true;
+    this->totalBlocks = 0;
+    this->scannedBlocks = 0;
     this->nodeType = FOR_NODE;
 }
 
@@ -58,6 +140,23 @@ void ForNode::print(int depth) {
     printKeyVal("node_type", getStringNodeType(getNodeType()), depth);
     printKeyVal("variable", this->variable, depth);
     printKeyVal("table", this->tableName, depth);
+    if (this->join.strategy != NESTED_LOOP_JOIN) {
+        printKeyVal("join", getStringJoinStrategy(this->join.strategy), depth);
+        printKeyVal("join_keys", (this->join.outerKey + " == " + this->join.innerKey).c_str(), depth);
+    }
+    if (this->join.strategy == HASH_JOIN) {
+        printKeyVal("build_side", this->join.buildOuter ? "outer" : "inner", depth);
+        printKeyVal("partitions", std::to_string(this->join.partitions).c_str(), depth);
+    }
+    if (this->stopAfter >= 0) {
+        printKeyVal("stop_after", std::to_string(this->stopAfter).c_str(), depth);
+    }
+    if (this->totalBlocks > 0) {
+        printKeyVal("blocks", (std::to_string(this->scannedBlocks) + "/" + std::to_string(this->totalBlocks)).c_str(), depth);
+    }
+    if (!this->wholeDocument) {
+        printKeyVal("projection", joinFields(this->projection).c_str(), depth);
+    }
     printKeyVal("actions", "", depth);
     if (this->action != nullptr) {
         this->action->print(depth + 1);
@@ -108,6 +207,19 @@ std::string Constant::getStrType() {
     }
 }
 
+// Equality key of a literal: numbers are keyed by their exact value so that
+// 5 and 5.0 match but 0 and 0.0000001 do not.
+std::string Constant::getValueKey() {
+    if (this->type == INT || this->type == FLOAT) {
+        // -0 and 0 are equal, so they get the same key.
+        double number = this->getNumVal() == 0 ? 0 : this->getNumVal();
+        char buffer[32];
+        char* end = std::to_chars(buffer, buffer + sizeof(buffer), number).ptr;
+        return "number:" + std::string(buffer, end);
+    }
+    return this->getStrType() + ":" + this->getStrVal();
+}
+
 void Constant::print(int depth) {
     printKeyVal("node_type", getStringNodeType(getNodeType()), depth);
     printKeyVal("type", this->getStrType().c_str(), depth);
@@ -130,11 +242,50 @@ void Condition::print(int depth) {
     this->rval->print(depth + 1);
 }
 
+void Condition::release() {
+    this->lval = nullptr;
+    this->rval = nullptr;
+}
+
 Condition::~Condition() {
     delete this->lval;
     delete this->rval;
 }
 
+// ------------------------------------------ InCondition ------------------------------------------
+
+void InCondition::setValue(Constant* value) {
+    this->value = value;
+}
+
+void InCondition::addValue(Constant* value) {
+    this->values.push_back(value);
+    this->lookup.insert(value->getValueKey());
+}
+
+// True when the list holds a string literal whose getStrVal() is value.
+bool InCondition::containsString(const std::string& value) {
+    return this->lookup.count("string:" + value) != 0;
+}
+
+void InCondition::print(int depth) {
+    printKeyVal("node_type", getStringNodeType(getNodeType()), depth);
+    printKeyVal("Left", "", depth);
+    this->value->print(depth + 1);
+    printKeyVal("Values", "", depth);
+    for (auto value : this->values) {
+        printKeyVal("value", "", depth + 1);
+        value->print(depth + 2);
+    }
+}
+
+InCondition::~InCondition() {
+    delete this->value;
+    for (auto value : this->values) {
+        delete value;
+    }
+}
+
 // ------------------------------------------ ConditionUnion ------------------------------------------
 
 const char* ConditionUnion::getStrOperator() {
@@ -148,25 +299,121 @@ const char* ConditionUnion::getStrOperator() {
     }
 };
 
-ConditionUnion::ConditionUnion(LogicalOp op, Predicate* lval, Predicate* rval) {
-    this->op = op;
-    this->lval = lval;
-    this->rval = rval;
-    this->nodeType = CONDITION_UNION_NODE;
+void ConditionUnion::addOperand(Predicate* operand) {
+    if (operand->getNodeType() == CONDITION_UNION_NODE && ((ConditionUnion*)operand)->op == this->op) {
+        ConditionUnion* other = (ConditionUnion*)operand;
+        this->operands.splice(this->operands.end(), other->operands);
+        delete other;
+    } else {
+        this->operands.push_back(operand);
+    }
+}
+
+Predicate* ConditionUnion::combine(LogicalOp op, Predicate* lval, Predicate* rval) {
+    ConditionUnion* node;
+    if (lval->getNodeType() == CONDITION_UNION_NODE && ((ConditionUnion*)lval)->op == op) {
+        node = (ConditionUnion*)lval;
+    } else {
+        node = new ConditionUnion(op);
+        node->addOperand(lval);
+    }
+    node->addOperand(rval);
+    return node;
+}
+
+// Equality tests of one reference against a literal, e.g. `x.id == 1`.
+static bool isRefEquality(Predicate* predicate) {
+    if (predicate->getNodeType() != CONDITION_NODE) {
+        return false;
+    }
+    Condition* condition = (Condition*)predicate;
+    return condition->getOperation() == EQ
+        && (condition->getLeft()->getType() == REF) != (condition->getRight()->getType() == REF);
+}
+
+static Constant* getEqualityRef(Condition* condition) {
+    return condition->getLeft()->getType() == REF ? condition->getLeft() : condition->getRight();
+}
+
+static Constant* getEqualityLiteral(Condition* condition) {
+    return condition->getLeft()->getType() == REF ? condition->getRight() : condition->getLeft();
+}
+
+// Rewrites long `x.f == a || x.f == b || ...` runs into one `x.f IN [a, b, ...]`
+// node. Takes ownership of predicate and returns the predicate to use instead.
+Predicate* ConditionUnion::foldMembership(Predicate* predicate) {
+    const size_t minFoldSize = 8;
+
+    if (predicate->getNodeType() != CONDITION_UNION_NODE) {
+        return predicate;
+    }
+    ConditionUnion* node = (ConditionUnion*)predicate;
+    for (auto& operand : node->operands) {
+        operand = foldMembership(operand);
+    }
+    if (node->op != OR) {
+        return node;
+    }
+
+    std::unordered_map<std::string, size_t> refCounts;
+    for (auto operand : node->operands) {
+        if (isRefEquality(operand)) {
+            refCounts[getEqualityRef((Condition*)operand)->getStrVal()]++;
+        }
+    }
+
+    std::unordered_map<std::string, InCondition*> folded;
+    for (auto it = node->operands.begin(); it != node->operands.end();) {
+        if (!isRefEquality(*it)) {
+            ++it;
+            continue;
+        }
+        Condition* condition = (Condition*)*it;
+        std::string ref = getEqualityRef(condition)->getStrVal();
+        if (refCounts[ref] < minFoldSize) {
+            ++it;
+            continue;
+        }
+        auto found = folded.find(ref);
+        if (found == folded.end()) {
+            InCondition* in = new InCondition();
+            in->setValue(getEqualityRef(condition));
+            in->addValue(getEqualityLiteral(condition));
+            folded[ref] = in;
+            *it = in;
+            ++it;
+        } else {
+            found->second->addValue(getEqualityLiteral(condition));
+            delete getEqualityRef(condition);
+            it = node->operands.erase(it);
+        }
+        condition->release();
+        delete condition;
+    }
+
+    if (node->operands.size() == 1) {
+        Predicate* single = node->operands.front();
+        node->operands.clear();
+        delete node;
+        return single;
+    }
+    return node;
 }
 
 void ConditionUnion::print(int depth) {
     printKeyVal("node_type", getStringNodeType(getNodeType()), depth);
     printKeyVal("Operation", getStrOperator(), depth);
-    printKeyVal("Left", "", depth);
-    this->lval->print(depth + 1);
-    printKeyVal("Right", "", depth);
-    this->rval->print(depth + 1);
+    printKeyVal("Operands", "", depth);
+    for (auto operand : this->operands) {
+        printKeyVal("operand", "", depth + 1);
+        operand->print(depth + 2);
+    }
 }
 
 ConditionUnion::~ConditionUnion() {
-    delete this->lval;
-    delete this->rval;
+    for (auto operand : this->operands) {
+        delete operand;
+    }
 }
 
 // ------------------------------------------ FilterNode ------------------------------------------
@@ -186,6 +433,95 @@ FilterNode::~FilterNode() {
     delete this->predicate;
 }
 
+// ------------------------------------------ LimitNode ------------------------------------------
+
+LimitNode::LimitNode(int offset, int count) {
+    this->offset = offset;
+    this->count = count;
+    this->nodeType = LIMIT_NODE;
+}
+
+void LimitNode::print(int depth) {
+    printKeyVal("node_type", getStringNodeType(getNodeType()), depth);
+    printKeyVal("offset", std::to_string(this->offset).c_str(), depth);
+    printKeyVal("count", std::to_string(this->count).c_str(), depth);
+}
+
+// ------------------------------------------ SortNode ------------------------------------------
+
+void SortNode::addKey(Constant* value, bool descending) {
+    this->keys.push_back({ value, descending });
+}
+
+void SortNode::setAlgorithm(SortAlgorithm algorithm, int topK) {
+    this->algorithm = algorithm;
+    this->topK = topK;
+}
+
+void SortNode::print(int depth) {
+    printKeyVal("node_type", getStringNodeType(getNodeType()), depth);
+    printKeyVal("algorithm", getStringSortAlgorithm(this->algorithm), depth);
+    if (this->algorithm == TOP_K_SORT) {
+        printKeyVal("k", std::to_string(this->topK).c_str(), depth);
+    }
+    printKeyVal("keys", "", depth);
+    for (auto key : this->keys) {
+        printKeyVal("key", "", depth + 1);
+        printKeyVal("direction", key.descending ? "desc" : "asc", depth + 2);
+        printKeyVal("value", "", depth + 2);
+        key.value->print(depth + 3);
+    }
+}
+
+SortNode::~SortNode() {
+    for (auto key : this->keys) {
+        delete key.value;
+    }
+}
+
+// ------------------------------------------ CollectNode ------------------------------------------
+
+void CollectNode::addGroup(const char* name, Constant* value) {
+    this->groups.push_back({ name, value });
+}
+
+void CollectNode::addAggregate(const char* name, AggregateFunction function, Constant* argument) {
+    this->aggregates.push_back({ name, function, argument });
+}
+
+void CollectNode::print(int depth) {
+    printKeyVal("node_type", getStringNodeType(getNodeType()), depth);
+    printKeyVal("algorithm", getStringAggregationAlgorithm(this->algorithm), depth);
+    printKeyVal("groups", "", depth);
+    for (auto group : this->groups) {
+        printKeyVal("group", "", depth + 1);
+        printKeyVal("name", group.name, depth + 2);
+        printKeyVal("value", "", depth + 2);
+        group.value->print(depth + 3);
+    }
+    printKeyVal("aggregates", "", depth);
+    for (auto aggregate : this->aggregates) {
+        printKeyVal("aggregate", "", depth + 1);
+        printKeyVal("name", aggregate.name, depth + 2);
+        printKeyVal("function", getStringAggregateFunction(aggregate.function), depth + 2);
+        if (aggregate.argument != nullptr) {
+            printKeyVal("argument", "", depth + 2);
+            aggregate.argument->print(depth + 3);
+        }
+    }
+}
+
+CollectNode::~CollectNode() {
+    for (auto group : this->groups) {
+        delete group.value;
+        free((void*)group.name);
+    }
+    for (auto aggregate : this->aggregates) {
+        delete aggregate.argument;
+        free((void*)aggregate.name);
+    }
+}
+
 // ------------------------------------------ ReturnAction ------------------------------------------
 
 ReturnAction::ReturnAction(Node* retVal) {
@@ -209,13 +545,24 @@ UpdateAction::UpdateAction(const char* variable, MapNode* value, const char* tab
     this->variable = variable;  
     this->value = value;
     this->table = table;
+    this->planned = false;
     this->nodeType = UPDATE_NODE;
 }
 
+void UpdateAction::setWriteSet(const std::set<std::string>& writeSet, const std::set<std::string>& indexUpdates) {
+    this->writeSet = writeSet;
+    this->indexUpdates = indexUpdates;
+    this->planned = true;
+}
+
 void UpdateAction::print(int depth) {
     printKeyVal("node_type", getStringNodeType(getNodeType()), depth);
     printKeyVal("variable", this->variable, depth + 1);
     printKeyVal("table", this->table, depth + 1);
+    if (this->planned) {
+        printKeyVal("write_set", joinFields(this->writeSet).c_str(), depth + 1);
+        printKeyVal("index_updates", joinFields(this->indexUpdates).c_str(), depth + 1);
+    }
     this->value->print(depth + 1);
 }
 
@@ -325,6 +672,25 @@ CreateTableNode::~CreateTableNode() {
     free((void*)this->table);
 }
 
+// ------------------------------------------ CreateIndexNode ------------------------------------------
+
+CreateIndexNode::CreateIndexNode(const char* table, const char* field) {
+    this->table = table;
+    this->field = field;
+    this->nodeType = CREATE_INDEX_NODE;
+}
+
+void CreateIndexNode::print(int depth) {
+    printKeyVal("node_type", getStringNodeType(getNodeType()), depth);
+    printKeyVal("table", this->table, depth);
+    printKeyVal("field", this->field, depth);
+}
+
+CreateIndexNode::~CreateIndexNode() {
+    free((void*)this->table);
+    free((void*)this->field);
+}
+
 // ------------------------------------------ DropTableNode ------------------------------------------
 
 DropTableNode::DropTableNode(const char* table) {
@@ -3,10 +3,15 @@
 
 #include <iostream>
 #include <list>
+#include <set>
+#include <string>
+#include <unordered_set>
 
 enum NodeType { FOR_NODE, ACTION_NODE, FILTER_NODE, RETURN_NODE, UPDATE_NODE, REMOVE_NODE, INSERT_NODE,
                 MAP_NODE, MAP_ENTRY_NODE, CONDITION_NODE, CONDITION_UNION_NODE, CONSTANT_NODE,
-                CREATE_TABLE_NODE, DROP_TABLE_NODE };
+                CREATE_TABLE_NODE, DROP_TABLE_NODE, CONDITION_IN_NODE,
+                CREATE_INDEX_NODE, LIMIT_NODE, SORT_NODE,
+                COLLECT_NODE };
 
 class Node {
     protected:
@@ -26,14 +31,48 @@ struct NodeWrapper {
 
 void printKeyVal(const char* key, const char* val, int depth);
 
+enum JoinStrategy { NESTED_LOOP_JOIN, HASH_JOIN, INDEX_NESTED_LOOP_JOIN, SORT_MERGE_JOIN };
+
+// How a FOR loop is joined with the loops enclosing it. Filled in by the planner.
+struct JoinPlan {
+    JoinStrategy strategy = NESTED_LOOP_JOIN;
+    std::string outerKey;
+    std::string innerKey;
+    bool buildOuter = false;
+    // Radix partitions the hash join build side is split into.
+    int partitions = 1;
+};
+
 class ForNode : public Node {
    private:
     const char* variable;
     const char* tableName;
     Node* action;
+    JoinPlan join;
+    int stopAfter;
+    // Fields of the loop variable the query reads; unused when it reads whole documents.
+    std::set<std::string> projection;
+    bool wholeDocument;
+    // Storage blocks of the table and how many of them the scan has to read.
+    int totalBlocks;
+    int scannedBlocks;
 
    public:
     ForNode(const char* variable, const char* tableName, Node* action);
+    const char* getVariable() { return this->variable; }
+    const char* getTableName() { return this->tableName; }
+    Node* getAction() { return this->action; }
+    JoinPlan& getJoin() { return this->join; }
+    int getStopAfter() { return this->stopAfter; }
+    void setStopAfter(int stopAfter) { this->stopAfter = stopAfter; }
+    void setBlocks(int scannedBlocks, int totalBlocks) {
+        this->scannedBlocks = scannedBlocks;
+        this->totalBlocks = totalBlocks;
+    }
+    void setProjection(const std::set<std::string>& fields, bool wholeDocument) {
+        this->projection = fields;
+        this->wholeDocument = wholeDocument;
+    }
     void print(int depth) override;
     ~ForNode();
 };
@@ -44,6 +83,7 @@ class ActionNode : public Node {
 
    public:
     ActionNode() { this->nodeType = ACTION_NODE; }
+    std::list<Node*>& getActions() { return this->actions; }
     void addAction(Node* action);
     void print(int depth) override;
     ~ActionNode();
@@ -61,7 +101,11 @@ public:
         this->nodeType = CONSTANT_NODE;
     }
     virtual std::string getStrVal() { return ""; };
+    // Value of an INT or FLOAT constant; 0 for the other types.
+    virtual double getNumVal() { return 0; };
+    DataType getType() { return this->type; }
     std::string getStrType();
+    std::string getValueKey();
     void print(int depth) override ;
 };
 
@@ -75,6 +119,9 @@ public:
     std::string getStrVal() override {
         return std::to_string(this->value);
     }
+    double getNumVal() override {
+        return this->value;
+    }
 };
 
 class IntConstant : public Constant {
@@ -87,6 +134,9 @@ public:
     std::string getStrVal() override {
         return std::to_string(this->value);
     }
+    double getNumVal() override {
+        return this->value;
+    }
 };
 
 class BoolConstant : public Constant {
@@ -135,21 +185,57 @@ class Condition : public Predicate {
         const char* operation_str[7] = { "==", "!=", ">", "<", ">=", "<=", "like" };
     public:   
         Condition(Constant* lval, Constant* rval, ConstantOperation op);
+        Constant* getLeft() { return this->lval; }
+        Constant* getRight() { return this->rval; }
+        ConstantOperation getOperation() { return this->op; }
+        void release();
         void print(int depth) override;
         ~Condition();
 };
 
+// `value IN [v1, v2, ...]`. Values are hashed once when the list is built,
+// so each membership test is a single set lookup.
+class InCondition : public Predicate {
+    private:
+        Constant* value;
+        std::list<Constant*> values;
+        std::unordered_set<std::string> lookup;
+
+    public:
+        InCondition() {
+            this->value = nullptr;
+            this->nodeType = CONDITION_IN_NODE;
+        }
+        Constant* getValue() { return this->value; }
+        std::list<Constant*>& getValues() { return this->values; }
+        void setValue(Constant* value);
+        void addValue(Constant* value);
+        bool containsString(const std::string& value);
+        void print(int depth) override;
+        ~InCondition();
+};
+
+// N-ary AND/OR node. Operands joined by the same operator are kept in one
+// flat list, so long `a || b || c ...` chains never nest.
 class ConditionUnion : public Predicate {
     private:
         LogicalOp op;
-        Predicate* lval;
-        Predicate* rval;
+        std::list<Predicate*> operands;
 
         const char* getStrOperator();
     public:
-        ConditionUnion(LogicalOp op, Predicate* lval, Predicate* rval);
+        ConditionUnion(LogicalOp op) {
+            this->op = op;
+            this->nodeType = CONDITION_UNION_NODE;
+        }
+        LogicalOp getOperator() { return this->op; }
+        std::list<Predicate*>& getOperands() { return this->operands; }
+        void addOperand(Predicate* operand);
         void print(int depth) override;
         ~ConditionUnion();
+
+        static Predicate* combine(LogicalOp op, Predicate* lval, Predicate* rval);
+        static Predicate* foldMembership(Predicate* predicate);
 };
 
 class FilterNode : public Node {
@@ -158,10 +244,82 @@ class FilterNode : public Node {
    public:
 
     FilterNode(Predicate* predicate);
+    Predicate* getPredicate() { return this->predicate; }
+    void setPredicate(Predicate* predicate) { this->predicate = predicate; }
     void print(int depth) override;
     ~FilterNode();
 };
 
+class LimitNode : public Node {
+   private:
+    int offset;
+    int count;
+   public:
+    LimitNode(int offset, int count);
+    int getOffset() { return this->offset; }
+    int getCount() { return this->count; }
+    void print(int depth) override;
+};
+
+struct SortKey {
+    Constant* value;
+    bool descending;
+};
+
+enum SortAlgorithm { COMPARISON_SORT, RADIX_SORT, TOP_K_SORT };
+
+class SortNode : public Node {
+   private:
+    std::list<SortKey> keys;
+    SortAlgorithm algorithm;
+    int topK;
+   public:
+    SortNode() {
+        this->algorithm = COMPARISON_SORT;
+        this->topK = 0;
+        this->nodeType = SORT_NODE;
+    }
+    std::list<SortKey>& getKeys() { return this->keys; }
+    void addKey(Constant* value, bool descending);
+    void setAlgorithm(SortAlgorithm algorithm, int topK = 0);
+    void print(int depth) override;
+    ~SortNode();
+};
+
+enum AggregateFunction { COUNT, SUM, MIN, MAX, AVG };
+
+struct GroupKey {
+    const char* name;
+    Constant* value;
+};
+
+struct Aggregate {
+    const char* name;
+    AggregateFunction function;
+    Constant* argument;
+};
+
+enum AggregationAlgorithm { HASH_AGGREGATION, SORTED_AGGREGATION, SCALAR_AGGREGATION };
+
+class CollectNode : public Node {
+   private:
+    std::list<GroupKey> groups;
+    std::list<Aggregate> aggregates;
+    AggregationAlgorithm algorithm;
+   public:
+    CollectNode() {
+        this->algorithm = HASH_AGGREGATION;
+        this->nodeType = COLLECT_NODE;
+    }
+    std::list<GroupKey>& getGroups() { return this->groups; }
+    std::list<Aggregate>& getAggregates() { return this->aggregates; }
+    void addGroup(const char* name, Constant* value);
+    void addAggregate(const char* name, AggregateFunction function, Constant* argument);
+    void setAlgorithm(AggregationAlgorithm algorithm) { this->algorithm = algorithm; }
+    void print(int depth) override;
+    ~CollectNode();
+};
+
 class TerminalAction : public Node {
 
 };
@@ -171,6 +329,7 @@ class ReturnAction : public TerminalAction {
         Node* retVal;
     public:
         ReturnAction(Node* retVal);
+        Node* getValue() { return this->retVal; }
         void print(int depth) override;
         ~ReturnAction();
 };
@@ -181,6 +340,8 @@ class MapEntry : public Node {
         Constant* value;
     public:
         MapEntry(const char* key, Constant* value);
+        const char* getKey() { return this->key; }
+        Constant* getValue() { return this->value; }
         void print(int depth) override;
         ~MapEntry();
 };
@@ -190,6 +351,7 @@ class MapNode : public Node {
         std::list<MapEntry*> entries;
     public:
         MapNode() { this->nodeType = MAP_NODE; }
+        std::list<MapEntry*>& getEntries() { return this->entries; }
         void addEntry(MapEntry* entry);
         void print(int depth) override;
         ~MapNode();
@@ -200,8 +362,16 @@ class UpdateAction : public TerminalAction {
         const char* variable;
         MapNode* value;
         const char* table;
+        // Fields the update actually changes and the indexes it has to maintain.
+        std::set<std::string> writeSet;
+        std::set<std::string> indexUpdates;
+        bool planned;
     public:
         UpdateAction(const char* variable, MapNode* value, const char* table);
+        const char* getVariable() { return this->variable; }
+        const char* getTable() { return this->table; }
+        MapNode* getValue() { return this->value; }
+        void setWriteSet(const std::set<std::string>& writeSet, const std::set<std::string>& indexUpdates);
         void print(int depth) override;
         ~UpdateAction();
 };
@@ -222,6 +392,8 @@ class InsertNode : public Node {
         const char* table;
     public:
         InsertNode(MapNode* map, const char* table);
+        const char* getTable() { return this->table; }
+        MapNode* getMap() { return this->map; }
         void print(int depth) override;
         ~InsertNode();
 };
@@ -232,15 +404,30 @@ class CreateTableNode : public Node {
         MapNode* fields;
     public:
         CreateTableNode(const char* table, MapNode* fields);
+        const char* getTable() { return this->table; }
+        MapNode* getFields() { return this->fields; }
         void print(int depth) override;
         ~CreateTableNode();
 };
 
+class CreateIndexNode : public Node {
+    private:
+        const char* table;
+        const char* field;
+    public:
+        CreateIndexNode(const char* table, const char* field);
+        const char* getTable() { return this->table; }
+        const char* getField() { return this->field; }
+        void print(int depth) override;
+        ~CreateIndexNode();
+};
+
 class DropTableNode : public Node {
     private:
         const char* table;
     public:
         DropTableNode(const char* table);
+        const char* getTable() { return this->table; }
         void print(int depth) override;
         ~DropTableNode();
 };
@@ -1,13 +1,19 @@
 #include <iostream>
 #include <string>
 #include "ast.h"
+#include "planner.h"
 #include "parser.h"
 #include "lexer.h"
 
+// Each call uses its own scanner, so queries can be parsed from several threads at once.
 int parseInput(std::string& query, NodeWrapper& nodeWrapper) {
-    yy_scan_string(query.c_str());
-    int code = yyparse(nodeWrapper);
-    yylex_destroy();
+    yyscan_t scanner;
+    yylex_init(&scanner);
+    yy_scan_string(query.c_str(), scanner);
+    // yy_scan_string leaves the new buffer's line count unset.
+    yyset_lineno(1, scanner);
+    int code = yyparse(scanner, nodeWrapper);
+    yylex_destroy(scanner);
     return code;
 }
 
@@ -15,6 +21,7 @@ int main() {
 
     std::string buf;
     std::string line;
+    Catalog catalog;
     std::cout << "> ";
     while(getline(std::cin, line)) {
         buf.append(line);
@@ -25,6 +32,8 @@ int main() {
             if (code) {
                 std::cout << "ret_code: " << code << std::endl;
             } else {
+                catalog.apply(nodeWrapper.node);
+                planQuery(nodeWrapper.node, catalog);
                 nodeWrapper.node->print(0);
                 delete nodeWrapper.node;
             }
@@ -55,7 +55,7 @@
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 0
+#define YYPURE 2
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -68,23 +68,15 @@
 
 /* First part of user prologue.  */
 #line 1 "parser.y"
-
-#include <iostream>
-#include <list>
-#include "ast.h"
-
-extern int yylex();
-
-void yyerror(NodeWrapper& node, const char *s){
-  extern int yylineno;
-  std::cerr << yylineno << ": error: " << s << std::endl;
-}
-
-
-int temp = 0;
-
-
-#line 88 "parser.c"
+
+#include <iostream>
+#include <list>
+#include "ast.h"
+
+int temp = 0;
+
+
+#line 80 "parser.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -124,49 +116,83 @@ enum yysymbol_kind_t
   YYSYMBOL_IN = 9,                         /* IN  */
   YYSYMBOL_FILTER = 10,                    /* FILTER  */
   YYSYMBOL_RETURN = 11,                    /* RETURN  */
-  YYSYMBOL_INSERT = 12,                    /* INSERT  */
-  YYSYMBOL_INTO = 13,                      /* INTO  */
-  YYSYMBOL_LPAREN = 14,                    /* LPAREN  */
-  YYSYMBOL_RPAREN = 15,                    /* RPAREN  */
-  YYSYMBOL_COLON = 16,                     /* COLON  */
-  YYSYMBOL_LBRACE = 17,                    /* LBRACE  */
-  YYSYMBOL_RBRACE = 18,                    /* RBRACE  */
-  YYSYMBOL_LOGIC_OP = 19,                  /* LOGIC_OP  */
-  YYSYMBOL_COMP_OP = 20,                   /* COMP_OP  */
-  YYSYMBOL_COMMA = 21,                     /* COMMA  */
-  YYSYMBOL_UPDATE = 22,                    /* UPDATE  */
-  YYSYMBOL_WITH = 23,                      /* WITH  */
-  YYSYMBOL_REMOVE = 24,                    /* REMOVE  */
-  YYSYMBOL_CREATE = 25,                    /* CREATE  */
-  YYSYMBOL_DROP = 26,                      /* DROP  */
-  YYSYMBOL_TABLE = 27,                     /* TABLE  */
-  YYSYMBOL_YYACCEPT = 28,                  /* $accept  */
-  YYSYMBOL_query = 29,                     /* query  */
-  YYSYMBOL_for_stmt = 30,                  /* for_stmt  */
-  YYSYMBOL_actions = 31,                   /* actions  */
-  YYSYMBOL_action = 32,                    /* action  */
-  YYSYMBOL_terminal_stmt = 33,             /* terminal_stmt  */
-  YYSYMBOL_filter_stmt = 34,               /* filter_stmt  */
-  YYSYMBOL_conditions = 35,                /* conditions  */
-  YYSYMBOL_condition = 36,                 /* condition  */
-  YYSYMBOL_constant = 37,                  /* constant  */
-  YYSYMBOL_return_stmt = 38,               /* return_stmt  */
-  YYSYMBOL_return_val = 39,                /* return_val  */
-  YYSYMBOL_update_stmt = 40,               /* update_stmt  */
-  YYSYMBOL_remove_stmt = 41,               /* remove_stmt  */
-  YYSYMBOL_map = 42,                       /* map  */
-  YYSYMBOL_map_items = 43,                 /* map_items  */
-  YYSYMBOL_map_item = 44,                  /* map_item  */
-  YYSYMBOL_id = 45,                        /* id  */
-  YYSYMBOL_value = 46,                     /* value  */
-  YYSYMBOL_insert_stmt = 47,               /* insert_stmt  */
-  YYSYMBOL_create_stmt = 48,               /* create_stmt  */
-  YYSYMBOL_drop_stmt = 49                  /* drop_stmt  */
+  YYSYMBOL_LIMIT = 12,                     /* LIMIT  */
+  YYSYMBOL_SORT = 13,                      /* SORT  */
+  YYSYMBOL_ASC = 14,                       /* ASC  */
+  YYSYMBOL_DESC = 15,                      /* DESC  */
+  YYSYMBOL_COLLECT = 16,                   /* COLLECT  */
+  YYSYMBOL_AGGREGATE = 17,                 /* AGGREGATE  */
+  YYSYMBOL_ASSIGN = 18,                    /* ASSIGN  */
+  YYSYMBOL_AGG_FUNC = 19,                  /* AGG_FUNC  */
+  YYSYMBOL_INSERT = 20,                    /* INSERT  */
+  YYSYMBOL_INTO = 21,                      /* INTO  */
+  YYSYMBOL_LPAREN = 22,                    /* LPAREN  */
+  YYSYMBOL_RPAREN = 23,                    /* RPAREN  */
+  YYSYMBOL_COLON = 24,                     /* COLON  */
+  YYSYMBOL_LBRACE = 25,                    /* LBRACE  */
+  YYSYMBOL_RBRACE = 26,                    /* RBRACE  */
+  YYSYMBOL_LBRACKET = 27,                  /* LBRACKET  */
+  YYSYMBOL_RBRACKET = 28,                  /* RBRACKET  */
+  YYSYMBOL_OR_OP = 29,                     /* OR_OP  */
+  YYSYMBOL_AND_OP = 30,                    /* AND_OP  */
+  YYSYMBOL_COMP_OP = 31,                   /* COMP_OP  */
+  YYSYMBOL_COMMA = 32,                     /* COMMA  */
+  YYSYMBOL_UPDATE = 33,                    /* UPDATE  */
+  YYSYMBOL_WITH = 34,                      /* WITH  */
+  YYSYMBOL_REMOVE = 35,                    /* REMOVE  */
+  YYSYMBOL_CREATE = 36,                    /* CREATE  */
+  YYSYMBOL_DROP = 37,                      /* DROP  */
+  YYSYMBOL_TABLE = 38,                     /* TABLE  */
+  YYSYMBOL_INDEX = 39,                     /* INDEX  */
+  YYSYMBOL_ON = 40,                        /* ON  */
+  YYSYMBOL_YYACCEPT = 41,                  /* $accept  */
+  YYSYMBOL_query = 42,                     /* query  */
+  YYSYMBOL_for_stmt = 43,                  /* for_stmt  */
+  YYSYMBOL_actions = 44,                   /* actions  */
+  YYSYMBOL_action = 45,                    /* action  */
+  YYSYMBOL_terminal_stmt = 46,             /* terminal_stmt  */
+  YYSYMBOL_filter_stmt = 47,               /* filter_stmt  */
+  YYSYMBOL_limit_stmt = 48,                /* limit_stmt  */
+  YYSYMBOL_sort_stmt = 49,                 /* sort_stmt  */
+  YYSYMBOL_sort_keys = 50,                 /* sort_keys  */
+  YYSYMBOL_sort_direction = 51,            /* sort_direction  */
+  YYSYMBOL_collect_stmt = 52,              /* collect_stmt  */
+  YYSYMBOL_collect_groups = 53,            /* collect_groups  */
+  YYSYMBOL_collect_aggregates = 54,        /* collect_aggregates  */
+  YYSYMBOL_aggregate_argument = 55,        /* aggregate_argument  */
+  YYSYMBOL_conditions = 56,                /* conditions  */
+  YYSYMBOL_condition = 57,                 /* condition  */
+  YYSYMBOL_in_list = 58,                   /* in_list  */
+  YYSYMBOL_in_items = 59,                  /* in_items  */
+  YYSYMBOL_constant = 60,                  /* constant  */
+  YYSYMBOL_return_stmt = 61,               /* return_stmt  */
+  YYSYMBOL_return_val = 62,                /* return_val  */
+  YYSYMBOL_update_stmt = 63,               /* update_stmt  */
+  YYSYMBOL_remove_stmt = 64,               /* remove_stmt  */
+  YYSYMBOL_map = 65,                       /* map  */
+  YYSYMBOL_map_items = 66,                 /* map_items  */
+  YYSYMBOL_map_item = 67,                  /* map_item  */
+  YYSYMBOL_id = 68,                        /* id  */
+  YYSYMBOL_value = 69,                     /* value  */
+  YYSYMBOL_insert_stmt = 70,               /* insert_stmt  */
+  YYSYMBOL_create_stmt = 71,               /* create_stmt  */
+  YYSYMBOL_drop_stmt = 72                  /* drop_stmt  */
 };
 typedef enum yysymbol_kind_t yysymbol_kind_t;
 
 
 
+/* Unqualified %code blocks.  */
+#line 14 "parser.y"
+
+extern int yylex(YYSTYPE* lvalp, yyscan_t scanner);
+extern int yyget_lineno(yyscan_t scanner);
+
+void yyerror(yyscan_t scanner, NodeWrapper& node, const char *s){
+  std::cerr << yyget_lineno(scanner) << ": error: " << s << std::endl;
+}
+
+#line 196 "parser.c"
 
 #ifdef short
 # undef short
@@ -278,7 +304,7 @@ typedef int yytype_uint16;
 
 
 /* Stored state numbers (used for stacks). */
-typedef yytype_int8 yy_state_t;
+typedef yytype_uint8 yy_state_t;
 
 /* State numbers in computations.  */
 typedef int yy_state_fast_t;
@@ -487,21 +513,21 @@ union yyalloc
 #endif /* !YYCOPY_NEEDED */
 
 /* YYFINAL -- State number of the termination state.  */
-#define YYFINAL  15
+#define YYFINAL  16
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   56
+#define YYLAST   135
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  28
+#define YYNTOKENS  41
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  22
+#define YYNNTS  32
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  38
+#define YYNRULES  65
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  70
+#define YYNSTATES  132
 
 /* YYMAXUTOK -- Last valid token kind.  */
-#define YYMAXUTOK   282
+#define YYMAXUTOK   295
 
 
 /* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
@@ -543,17 +569,21 @@ static const yytype_int8 yytranslate[] =
        2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
        5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
       15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
-      25,    26,    27
+      25,    26,    27,    28,    29,    30,    31,    32,    33,    34,
+      35,    36,    37,    38,    39,    40
 };
 
 #if YYDEBUG
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    79,    79,    80,    81,    82,    84,    86,    87,    89,
-      90,    91,    93,    94,    95,    97,   100,   101,   103,   107,
-     107,   110,   112,   113,   115,   117,   119,   120,   122,   123,
-     125,   127,   129,   130,   131,   132,   134,   136,   138
+       0,   108,   108,   109,   110,   111,   113,   115,   116,   118,
+     119,   120,   121,   122,   123,   125,   126,   127,   129,   131,
+     135,   140,   142,   143,   145,   146,   147,   149,   150,   152,
+     153,   155,   156,   157,   160,   164,   167,   168,   169,   171,
+     174,   176,   177,   179,   180,   182,   182,   185,   187,   188,
+     190,   192,   194,   195,   197,   198,   200,   202,   204,   205,
+     206,   207,   209,   211,   212,   214
 };
 #endif
 
@@ -571,10 +601,14 @@ static const char *const yytname[] =
 {
   "\"end of file\"", "error", "\"invalid token\"", "ID", "STRING_TOKEN",
   "BOOL_TOKEN", "INT_TOKEN", "FLOAT_TOKEN", "FOR", "IN", "FILTER",
-  "RETURN", "INSERT", "INTO", "LPAREN", "RPAREN", "COLON", "LBRACE",
-  "RBRACE", "LOGIC_OP", "COMP_OP", "COMMA", "UPDATE", "WITH", "REMOVE",
-  "CREATE", "DROP", "TABLE", "$accept", "query", "for_stmt", "actions",
-  "action", "terminal_stmt", "filter_stmt", "conditions", "condition",
+  "RETURN", "LIMIT", "SORT", "ASC", "DESC", "COLLECT", "AGGREGATE",
+  "ASSIGN", "AGG_FUNC", "INSERT", "INTO", "LPAREN", "RPAREN", "COLON",
+  "LBRACE", "RBRACE", "LBRACKET", "RBRACKET", "OR_OP", "AND_OP", "COMP_OP",
+  "COMMA", "UPDATE", "WITH", "REMOVE", "CREATE", "DROP", "TABLE", "INDEX",
+  "ON", "$accept", "query", "for_stmt", "actions", "action",
+  "terminal_stmt", "filter_stmt", "limit_stmt", "sort_stmt", "sort_keys",
+  "sort_direction", "collect_stmt", "collect_groups", "collect_aggregates",
+  "aggregate_argument", "conditions", "condition", "in_list", "in_items",
   "constant", "return_stmt", "return_val", "update_stmt", "remove_stmt",
   "map", "map_items", "map_item", "id", "value", "insert_stmt",
   "create_stmt", "drop_stmt", YY_NULLPTR
@@ -587,7 +621,7 @@ yysymbol_name (yysymbol_kind_t yysymbol)
 }
 #endif
 
-#define YYPACT_NINF (-25)
+#define YYPACT_NINF (-93)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
@@ -601,13 +635,20 @@ yysymbol_name (yysymbol_kind_t yysymbol)
    STATE-NUM.  */
 static const yytype_int8 yypact[] =
 {
-      -6,     1,   -12,    -9,    -4,    21,   -25,   -25,   -25,   -25,
-      16,    -1,    19,    30,    31,   -25,    32,    20,   -25,    23,
-      17,    36,   -12,   -25,     0,    24,   -25,    38,   -25,   -25,
-      24,     9,    40,    41,   -25,     0,   -25,   -25,   -25,   -25,
-     -25,   -25,   -25,   -25,   -25,   -25,   -25,   -25,   -25,   -25,
-     -25,    26,   -25,    27,   -25,   -25,   -25,    25,    37,   -25,
-      24,    24,   -12,    46,   -25,   -25,    42,   -25,    47,   -25
+      -5,    26,   -21,   -28,    23,    69,   -93,   -93,   -93,   -93,
+      64,     1,    53,    72,    36,    74,   -93,    75,    55,   -93,
+      54,    49,    79,   -21,    81,   -93,     6,    61,   -93,    82,
+     -93,   -93,    63,    61,    30,    83,    84,    37,    85,    87,
+     -93,     6,   -93,   -93,   -93,   -93,   -93,   -93,    21,    59,
+     -93,   -93,   -93,   -93,   -93,   -93,   -93,   -93,   -93,   -93,
+     -93,   -93,    89,    -9,   -93,    -3,   -93,   -93,   -93,    62,
+      65,    45,    77,    90,    66,    92,   -93,    95,    96,    99,
+      80,    61,    61,    78,    61,    98,    84,   -93,   -93,   -93,
+      61,    88,   -21,   104,    91,    93,    94,   -93,    86,   -93,
+      19,   -93,   -93,   -93,    45,   -93,   100,   101,   -93,   102,
+      61,   103,   -93,   -19,   -93,   -93,   105,   110,   105,   -93,
+     105,   -93,    44,    39,   -93,   -93,   -93,   -93,   -93,   -93,
+      97,   -93
 };
 
 /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
@@ -616,82 +657,120 @@ static const yytype_int8 yypact[] =
 static const yytype_int8 yydefact[] =
 {
        0,     0,     0,     0,     0,     0,     2,     3,     4,     5,
-       0,     0,     0,     0,     0,     1,     0,     0,    27,     0,
-      28,     0,     0,    38,     0,     0,    26,     0,    36,    37,
-       0,     0,     0,     0,     9,     6,     8,    11,    10,    12,
-      13,    14,    31,    34,    35,    32,    33,    30,    19,    20,
-      29,    15,    16,     0,    22,    21,    23,     0,     0,     7,
-       0,     0,     0,     0,    17,    18,     0,    25,     0,    24
+       0,     0,     0,     0,     0,     0,     1,     0,     0,    53,
+       0,    54,     0,     0,     0,    65,     0,     0,    52,     0,
+      62,    63,     0,     0,     0,     0,     0,     0,     0,     0,
+       9,     6,     8,    14,    10,    11,    12,    13,    27,    28,
+      15,    16,    17,    57,    60,    61,    58,    59,    56,    45,
+      46,    55,     0,    18,    36,     0,    48,    47,    49,    19,
+      21,    24,     0,     0,     0,     0,     7,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,    25,    26,    22,
+       0,     0,     0,     0,     0,     0,     0,    64,    37,    38,
+       0,    40,    39,    20,    24,    29,     0,     0,    51,     0,
+       0,     0,    42,     0,    43,    23,     0,     0,     0,    30,
+       0,    41,     0,     0,    32,    50,    31,    33,    44,    34,
+       0,    35
 };
 
 /* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-     -25,   -25,    52,   -25,    18,   -25,   -25,    -5,   -25,   -24,
-     -25,   -25,   -25,   -25,   -22,    29,   -25,   -25,   -25,   -25,
-     -25,   -25
+     -93,   -93,   108,   -93,    73,   -93,   -93,   -93,   -93,   -93,
+      11,   -93,   -93,   -93,   -62,   -10,   -93,   -93,   -93,   -27,
+     -93,   -93,   -93,   -93,   -22,   106,   -93,   -34,   -92,   -93,
+     -93,   -93
 };
 
 /* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-       0,     5,    34,    35,    36,    37,    38,    51,    52,    53,
-      39,    55,    40,    41,    12,    19,    20,    48,    49,     7,
+       0,     5,    40,    41,    42,    43,    44,    45,    46,    70,
+      89,    47,    48,    49,   124,    63,    64,   101,   113,    65,
+      50,    67,    51,    52,    12,    20,    21,    59,    60,     7,
        8,     9
 };
 
 /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
    positive, shift that token.  If negative, reduce the rule whose
    number is the opposite.  If YYTABLE_NINF, syntax error.  */
-static const yytype_int8 yytable[] =
+static const yytype_uint8 yytable[] =
 {
-      29,    47,     1,    17,    10,    11,     2,    54,     1,    56,
-      30,    31,    42,    43,    44,    45,    46,    18,    13,     3,
-       4,    15,    32,    14,    33,    16,    11,    42,    43,    44,
-      45,    46,    21,    22,    23,    24,    25,    65,    27,    28,
-      66,    26,    17,    57,    58,    60,    63,    61,    62,    67,
-      69,    68,     6,    59,     0,    64,    50
+      58,    31,    71,     1,    11,    18,    83,    66,   114,   121,
+      13,    14,    68,   122,     1,     2,    33,    34,    35,    36,
+      81,    82,    37,    54,    55,    56,    57,    19,    84,    10,
+     128,     3,     4,    53,    54,    55,    56,    57,    77,    38,
+      72,    39,    53,    54,    55,    56,    57,   112,    54,    55,
+      56,    57,   104,    78,    73,    11,   126,   102,   127,    87,
+      88,    15,   129,   105,    53,    54,    55,    56,    57,    16,
+     107,    98,    99,    17,    22,    23,    24,    25,    26,    27,
+      28,    29,    30,   119,    32,    62,    18,    53,    74,    69,
+      75,    79,    80,    91,    85,    90,   130,    86,    94,    95,
+      92,    93,    96,    97,   103,   100,   106,   108,     6,   109,
+     117,   110,   111,   125,    76,   115,    82,     0,     0,   116,
+     131,   118,   120,     0,     0,     0,     0,   123,     0,     0,
+       0,     0,     0,     0,     0,    61
 };
 
 static const yytype_int8 yycheck[] =
 {
-      22,    25,     8,     4,     3,    17,    12,    31,     8,    31,
-      10,    11,     3,     4,     5,     6,     7,    18,    27,    25,
-      26,     0,    22,    27,    24,     9,    17,     3,     4,     5,
-       6,     7,    13,     3,     3,     3,    16,    61,    21,     3,
-      62,    18,     4,     3,     3,    19,     9,    20,    23,     3,
-       3,     9,     0,    35,    -1,    60,    27
+      27,    23,    36,     8,    25,     4,     9,    34,   100,    28,
+      38,    39,    34,    32,     8,    20,    10,    11,    12,    13,
+      29,    30,    16,     4,     5,     6,     7,    26,    31,     3,
+     122,    36,    37,     3,     4,     5,     6,     7,    17,    33,
+       3,    35,     3,     4,     5,     6,     7,    28,     4,     5,
+       6,     7,    86,    32,    17,    25,   118,    84,   120,    14,
+      15,    38,    23,    90,     3,     4,     5,     6,     7,     0,
+      92,    81,    82,     9,    21,     3,    40,     3,     3,    24,
+      26,    32,     3,   110,     3,    22,     4,     3,     3,     6,
+       3,    32,     3,     3,    32,    18,   123,    32,     3,     3,
+      34,     9,     3,    23,     6,    27,    18,     3,     0,    18,
+       9,    18,    18,     3,    41,   104,    30,    -1,    -1,    19,
+      23,    19,    19,    -1,    -1,    -1,    -1,    22,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    29
 };
 
 /* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
    state STATE-NUM.  */
 static const yytype_int8 yystos[] =
 {
-       0,     8,    12,    25,    26,    29,    30,    47,    48,    49,
-       3,    17,    42,    27,    27,     0,     9,     4,    18,    43,
-      44,    13,     3,     3,     3,    16,    18,    21,     3,    42,
-      10,    11,    22,    24,    30,    31,    32,    33,    34,    38,
-      40,    41,     3,     4,     5,     6,     7,    37,    45,    46,
-      43,    35,    36,    37,    37,    39,    42,     3,     3,    32,
-      19,    20,    23,     9,    35,    37,    42,     3,     9,     3
+       0,     8,    20,    36,    37,    42,    43,    70,    71,    72,
+       3,    25,    65,    38,    39,    38,     0,     9,     4,    26,
+      66,    67,    21,     3,    40,     3,     3,    24,    26,    32,
+       3,    65,     3,    10,    11,    12,    13,    16,    33,    35,
+      43,    44,    45,    46,    47,    48,    49,    52,    53,    54,
+      61,    63,    64,     3,     4,     5,     6,     7,    60,    68,
+      69,    66,    22,    56,    57,    60,    60,    62,    65,     6,
+      50,    68,     3,    17,     3,     3,    45,    17,    32,    32,
+       3,    29,    30,     9,    31,    32,    32,    14,    15,    51,
+      18,     3,    34,     9,     3,     3,     3,    23,    56,    56,
+      27,    58,    60,     6,    68,    60,    18,    65,     3,    18,
+      18,    18,    28,    59,    69,    51,    19,     9,    19,    60,
+      19,    28,    32,    22,    55,     3,    55,    55,    69,    23,
+      60,    23
 };
 
 /* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr1[] =
 {
-       0,    28,    29,    29,    29,    29,    30,    31,    31,    32,
-      32,    32,    33,    33,    33,    34,    35,    35,    36,    37,
-      37,    38,    39,    39,    40,    41,    42,    42,    43,    43,
-      44,    45,    46,    46,    46,    46,    47,    48,    49
+       0,    41,    42,    42,    42,    42,    43,    44,    44,    45,
+      45,    45,    45,    45,    45,    46,    46,    46,    47,    48,
+      48,    49,    50,    50,    51,    51,    51,    52,    52,    53,
+      53,    54,    54,    54,    55,    55,    56,    56,    56,    57,
+      57,    58,    58,    59,    59,    60,    60,    61,    62,    62,
+      63,    64,    65,    65,    66,    66,    67,    68,    69,    69,
+      69,    69,    70,    71,    71,    72
 };
 
 /* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
        0,     2,     1,     1,     1,     1,     5,     2,     1,     1,
-       1,     1,     1,     1,     1,     2,     1,     3,     3,     1,
-       1,     2,     1,     1,     6,     4,     3,     2,     1,     3,
-       3,     1,     1,     1,     1,     1,     4,     4,     3
+       1,     1,     1,     1,     1,     1,     1,     1,     2,     2,
+       4,     2,     2,     4,     0,     1,     1,     1,     1,     4,
+       5,     6,     6,     6,     2,     3,     1,     3,     3,     3,
+       3,     3,     2,     1,     3,     1,     1,     2,     1,     1,
+       6,     4,     3,     2,     1,     3,     3,     1,     1,     1,
+       1,     1,     4,     4,     7,     3
 };
 
 
@@ -720,7 +799,7 @@ enum { YYENOMEM = -2 };
       }                                                           \
     else                                                          \
       {                                                           \
-        yyerror (root, YY_("syntax error: cannot back up")); \
+        yyerror (scanner, root, YY_("syntax error: cannot back up")); \
         YYERROR;                                                  \
       }                                                           \
   while (0)
@@ -753,7 +832,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Kind, Value, root); \
+                  Kind, Value, scanner, root); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -765,10 +844,11 @@ do {                                                                      \
 
 static void
 yy_symbol_value_print (FILE *yyo,
-                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, NodeWrapper& root)
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner, NodeWrapper& root)
 {
   FILE *yyoutput = yyo;
   YY_USE (yyoutput);
+  YY_USE (scanner);
   YY_USE (root);
   if (!yyvaluep)
     return;
@@ -784,12 +864,12 @@ yy_symbol_value_print (FILE *yyo,
 
 static void
 yy_symbol_print (FILE *yyo,
-                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, NodeWrapper& root)
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner, NodeWrapper& root)
 {
   YYFPRINTF (yyo, "%s %s (",
              yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyo, yykind, yyvaluep, root);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, scanner, root);
   YYFPRINTF (yyo, ")");
 }
 
@@ -823,7 +903,7 @@ do {                                                            \
 
 static void
 yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
-                 int yyrule, NodeWrapper& root)
+                 int yyrule, yyscan_t scanner, NodeWrapper& root)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -836,7 +916,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
                        YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
-                       &yyvsp[(yyi + 1) - (yynrhs)], root);
+                       &yyvsp[(yyi + 1) - (yynrhs)], scanner, root);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -844,7 +924,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, Rule, root); \
+    yy_reduce_print (yyssp, yyvsp, Rule, scanner, root); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -1152,9 +1232,10 @@ yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
 
 static void
 yydestruct (const char *yymsg,
-            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, NodeWrapper& root)
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, yyscan_t scanner, NodeWrapper& root)
 {
   YY_USE (yyvaluep);
+  YY_USE (scanner);
   YY_USE (root);
   if (!yymsg)
     yymsg = "Deleting";
@@ -1166,13 +1247,6 @@ yydestruct (const char *yymsg,
 }
 
 
-/* Lookahead token kind.  */
-int yychar;
-
-/* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval;
-/* Number of syntax errors so far.  */
-int yynerrs;
 
 
 
@@ -1182,8 +1256,21 @@ int yynerrs;
 `----------*/
 
 int
-yyparse (NodeWrapper& root)
+yyparse (yyscan_t scanner, NodeWrapper& root)
 {
+/* Lookahead token kind.  */
+int yychar;
+
+
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
+
     yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
     int yyerrstatus = 0;
@@ -1339,7 +1426,7 @@ yybackup:
   if (yychar == YYEMPTY)
     {
       YYDPRINTF ((stderr, "Reading a token\n"));
-      yychar = yylex ();
+      yychar = yylex (&yylval, scanner);
     }
 
   if (yychar <= YYEOF)
@@ -1427,225 +1514,396 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* query: for_stmt  */
-#line 79 "parser.y"
+#line 108 "parser.y"
                  { root.node = (yyvsp[0].node);  }
-#line 1433 "parser.c"
+#line 1520 "parser.c"
     break;
 
   case 3: /* query: insert_stmt  */
-#line 80 "parser.y"
+#line 109 "parser.y"
                     { root.node = (yyvsp[0].node); }
-#line 1439 "parser.c"
+#line 1526 "parser.c"
     break;
 
   case 4: /* query: create_stmt  */
-#line 81 "parser.y"
+#line 110 "parser.y"
                     { root.node = (yyvsp[0].node); }
-#line 1445 "parser.c"
+#line 1532 "parser.c"
     break;
 
   case 5: /* query: drop_stmt  */
-#line 82 "parser.y"
+#line 111 "parser.y"
                   { root.node = (yyvsp[0].node); }
-#line 1451 "parser.c"
+#line 1538 "parser.c"
     break;
 
   case 6: /* for_stmt: FOR ID IN ID actions  */
-#line 84 "parser.y"
+#line 113 "parser.y"
                                { (yyval.node) = new ForNode((yyvsp[-3].str), (yyvsp[-1].str), (yyvsp[0].action)); }
-#line 1457 "parser.c"
+#line 1544 "parser.c"
     break;
 
   case 7: /* actions: actions action  */
-#line 86 "parser.y"
+#line 115 "parser.y"
                         { (yyval.action) = (yyvsp[-1].action); (yyvsp[-1].action)->addAction((yyvsp[0].node)); }
-#line 1463 "parser.c"
+#line 1550 "parser.c"
     break;
 
   case 8: /* actions: action  */
-#line 87 "parser.y"
+#line 116 "parser.y"
                  { (yyval.action) = new ActionNode(); (yyval.action)->addAction((yyvsp[0].node)); }
-#line 1469 "parser.c"
+#line 1556 "parser.c"
     break;
 
   case 9: /* action: for_stmt  */
-#line 89 "parser.y"
+#line 118 "parser.y"
                  { (yyval.node) = (yyvsp[0].node); }
-#line 1475 "parser.c"
+#line 1562 "parser.c"
     break;
 
   case 10: /* action: filter_stmt  */
-#line 90 "parser.y"
+#line 119 "parser.y"
                     { (yyval.node) = (yyvsp[0].node); }
-#line 1481 "parser.c"
+#line 1568 "parser.c"
     break;
 
-  case 11: /* action: terminal_stmt  */
-#line 91 "parser.y"
+  case 11: /* action: limit_stmt  */
+#line 120 "parser.y"
+                   { (yyval.node) = (yyvsp[0].node); }
+#line 1574 "parser.c"
+    break;
+
+  case 12: /* action: sort_stmt  */
+#line 121 "parser.y"
+                  { (yyval.node) = (yyvsp[0].sort); }
+#line 1580 "parser.c"
+    break;
+
+  case 13: /* action: collect_stmt  */
+#line 122 "parser.y"
+                     { (yyval.node) = (yyvsp[0].collect); }
+#line 1586 "parser.c"
+    break;
+
+  case 14: /* action: terminal_stmt  */
+#line 123 "parser.y"
                        { (yyval.node) = (yyvsp[0].terminal); }
-#line 1487 "parser.c"
+#line 1592 "parser.c"
     break;
 
-  case 12: /* terminal_stmt: return_stmt  */
-#line 93 "parser.y"
+  case 15: /* terminal_stmt: return_stmt  */
+#line 125 "parser.y"
                            { (yyval.terminal) = (yyvsp[0].terminal); }
-#line 1493 "parser.c"
+#line 1598 "parser.c"
     break;
 
-  case 13: /* terminal_stmt: update_stmt  */
-#line 94 "parser.y"
+  case 16: /* terminal_stmt: update_stmt  */
+#line 126 "parser.y"
                             { (yyval.terminal) = (yyvsp[0].terminal); }
-#line 1499 "parser.c"
+#line 1604 "parser.c"
     break;
 
-  case 14: /* terminal_stmt: remove_stmt  */
-#line 95 "parser.y"
+  case 17: /* terminal_stmt: remove_stmt  */
+#line 127 "parser.y"
                             { (yyval.terminal) = (yyvsp[0].terminal); }
-#line 1505 "parser.c"
+#line 1610 "parser.c"
+    break;
+
+  case 18: /* filter_stmt: FILTER conditions  */
+#line 129 "parser.y"
+                               { (yyval.node) = new FilterNode(ConditionUnion::foldMembership((yyvsp[0].predicate))); }
+#line 1616 "parser.c"
+    break;
+
+  case 19: /* limit_stmt: LIMIT INT_TOKEN  */
+#line 131 "parser.y"
+                            {
+                                if ((yyvsp[0].intVal) < 0) { yyerror(scanner, root, "LIMIT count must not be negative"); YYERROR; }
+                                (yyval.node) = new LimitNode(0, (yyvsp[0].intVal));
+                                }
+#line 1625 "parser.c"
+    break;
+
+  case 20: /* limit_stmt: LIMIT INT_TOKEN COMMA INT_TOKEN  */
+#line 135 "parser.y"
+                                            {
+                                if ((yyvsp[-2].intVal) < 0 || (yyvsp[0].intVal) < 0) { yyerror(scanner, root, "LIMIT offset and count must not be negative"); YYERROR; }
+                                (yyval.node) = new LimitNode((yyvsp[-2].intVal), (yyvsp[0].intVal));
+                                }
+#line 1634 "parser.c"
+    break;
+
+  case 21: /* sort_stmt: SORT sort_keys  */
+#line 140 "parser.y"
+                          { (yyval.sort) = (yyvsp[0].sort); }
+#line 1640 "parser.c"
+    break;
+
+  case 22: /* sort_keys: id sort_direction  */
+#line 142 "parser.y"
+                             { (yyval.sort) = new SortNode(); (yyval.sort)->addKey((yyvsp[-1].constant), (yyvsp[0].boolVal)); }
+#line 1646 "parser.c"
+    break;
+
+  case 23: /* sort_keys: sort_keys COMMA id sort_direction  */
+#line 143 "parser.y"
+                                              { (yyval.sort) = (yyvsp[-3].sort); (yyvsp[-3].sort)->addKey((yyvsp[-1].constant), (yyvsp[0].boolVal)); }
+#line 1652 "parser.c"
     break;
 
-  case 15: /* filter_stmt: FILTER conditions  */
-#line 97 "parser.y"
-                               { (yyval.node) = new FilterNode((yyvsp[0].predicate)); }
-#line 1511 "parser.c"
+  case 24: /* sort_direction: %empty  */
+#line 145 "parser.y"
+                       { (yyval.boolVal) = false; }
+#line 1658 "parser.c"
     break;
 
-  case 16: /* conditions: condition  */
-#line 100 "parser.y"
+  case 25: /* sort_direction: ASC  */
+#line 146 "parser.y"
+                    { (yyval.boolVal) = false; }
+#line 1664 "parser.c"
+    break;
+
+  case 26: /* sort_direction: DESC  */
+#line 147 "parser.y"
+                     { (yyval.boolVal) = true; }
+#line 1670 "parser.c"
+    break;
+
+  case 27: /* collect_stmt: collect_groups  */
+#line 149 "parser.y"
+                             { (yyval.collect) = (yyvsp[0].collect); }
+#line 1676 "parser.c"
+    break;
+
+  case 28: /* collect_stmt: collect_aggregates  */
+#line 150 "parser.y"
+                                 { (yyval.collect) = (yyvsp[0].collect); }
+#line 1682 "parser.c"
+    break;
+
+  case 29: /* collect_groups: COLLECT ID ASSIGN constant  */
+#line 152 "parser.y"
+                                           { (yyval.collect) = new CollectNode(); (yyval.collect)->addGroup((yyvsp[-2].str), (yyvsp[0].constant)); }
+#line 1688 "parser.c"
+    break;
+
+  case 30: /* collect_groups: collect_groups COMMA ID ASSIGN constant  */
+#line 153 "parser.y"
+                                                        { (yyval.collect) = (yyvsp[-4].collect); (yyvsp[-4].collect)->addGroup((yyvsp[-2].str), (yyvsp[0].constant)); }
+#line 1694 "parser.c"
+    break;
+
+  case 31: /* collect_aggregates: collect_groups AGGREGATE ID ASSIGN AGG_FUNC aggregate_argument  */
+#line 155 "parser.y"
+                                                                                   { (yyval.collect) = (yyvsp[-5].collect); (yyvsp[-5].collect)->addAggregate((yyvsp[-3].str), (yyvsp[-1].aggFunc), (yyvsp[0].constant)); }
+#line 1700 "parser.c"
+    break;
+
+  case 32: /* collect_aggregates: COLLECT AGGREGATE ID ASSIGN AGG_FUNC aggregate_argument  */
+#line 156 "parser.y"
+                                                                            { (yyval.collect) = new CollectNode(); (yyval.collect)->addAggregate((yyvsp[-3].str), (yyvsp[-1].aggFunc), (yyvsp[0].constant)); }
+#line 1706 "parser.c"
+    break;
+
+  case 33: /* collect_aggregates: collect_aggregates COMMA ID ASSIGN AGG_FUNC aggregate_argument  */
+#line 157 "parser.y"
+                                                                                   { (yyval.collect) = (yyvsp[-5].collect); (yyvsp[-5].collect)->addAggregate((yyvsp[-3].str), (yyvsp[-1].aggFunc), (yyvsp[0].constant)); }
+#line 1712 "parser.c"
+    break;
+
+  case 34: /* aggregate_argument: LPAREN RPAREN  */
+#line 160 "parser.y"
+                                  {
+                                if ((yyvsp[-2].aggFunc) != COUNT) { yyerror(scanner, root, "only COUNT can be called without an argument"); YYERROR; }
+                                (yyval.constant) = nullptr;
+                                }
+#line 1721 "parser.c"
+    break;
+
+  case 35: /* aggregate_argument: LPAREN constant RPAREN  */
+#line 164 "parser.y"
+                                           { (yyval.constant) = (yyvsp[-1].constant); }
+#line 1727 "parser.c"
+    break;
+
+  case 36: /* conditions: condition  */
+#line 167 "parser.y"
                                            { (yyval.predicate) = (yyvsp[0].predicate); }
-#line 1517 "parser.c"
+#line 1733 "parser.c"
     break;
 
-  case 17: /* conditions: conditions LOGIC_OP conditions  */
-#line 101 "parser.y"
-                                           { (yyval.predicate) = new ConditionUnion((yyvsp[-1].logicOp), (yyvsp[-2].predicate), (yyvsp[0].predicate)); }
-#line 1523 "parser.c"
+  case 37: /* conditions: conditions OR_OP conditions  */
+#line 168 "parser.y"
+                                           { (yyval.predicate) = ConditionUnion::combine(OR, (yyvsp[-2].predicate), (yyvsp[0].predicate)); }
+#line 1739 "parser.c"
     break;
 
-  case 18: /* condition: constant COMP_OP constant  */
-#line 103 "parser.y"
-                                     {
-                                        (yyval.predicate) = new Condition((yyvsp[-2].constant), (yyvsp[0].constant), (yyvsp[-1].compOp));
+  case 38: /* conditions: conditions AND_OP conditions  */
+#line 169 "parser.y"
+                                           { (yyval.predicate) = ConditionUnion::combine(AND, (yyvsp[-2].predicate), (yyvsp[0].predicate)); }
+#line 1745 "parser.c"
+    break;
+
+  case 39: /* condition: constant COMP_OP constant  */
+#line 171 "parser.y"
+                                     {
+                                        (yyval.predicate) = new Condition((yyvsp[-2].constant), (yyvsp[0].constant), (yyvsp[-1].compOp));
                                         }
-#line 1531 "parser.c"
+#line 1753 "parser.c"
     break;
 
-  case 20: /* constant: value  */
-#line 107 "parser.y"
+  case 40: /* condition: constant IN in_list  */
+#line 174 "parser.y"
+                                { (yyvsp[0].inCondition)->setValue((yyvsp[-2].constant)); (yyval.predicate) = (yyvsp[0].inCondition); }
+#line 1759 "parser.c"
+    break;
+
+  case 41: /* in_list: LBRACKET in_items RBRACKET  */
+#line 176 "parser.y"
+                                    { (yyval.inCondition) = (yyvsp[-1].inCondition); }
+#line 1765 "parser.c"
+    break;
+
+  case 42: /* in_list: LBRACKET RBRACKET  */
+#line 177 "parser.y"
+                            { (yyval.inCondition) = new InCondition(); }
+#line 1771 "parser.c"
+    break;
+
+  case 43: /* in_items: value  */
+#line 179 "parser.y"
+                { (yyval.inCondition) = new InCondition(); (yyval.inCondition)->addValue((yyvsp[0].constant)); }
+#line 1777 "parser.c"
+    break;
+
+  case 44: /* in_items: in_items COMMA value  */
+#line 180 "parser.y"
+                               { (yyval.inCondition) = (yyvsp[-2].inCondition); (yyvsp[-2].inCondition)->addValue((yyvsp[0].constant)); }
+#line 1783 "parser.c"
+    break;
+
+  case 46: /* constant: value  */
+#line 182 "parser.y"
                       { (yyval.constant) = (yyvsp[0].constant); }
-#line 1537 "parser.c"
+#line 1789 "parser.c"
     break;
 
-  case 21: /* return_stmt: RETURN return_val  */
-#line 110 "parser.y"
+  case 47: /* return_stmt: RETURN return_val  */
+#line 185 "parser.y"
                                { (yyval.terminal) = new ReturnAction((yyvsp[0].node)); }
-#line 1543 "parser.c"
+#line 1795 "parser.c"
     break;
 
-  case 22: /* return_val: constant  */
-#line 112 "parser.y"
+  case 48: /* return_val: constant  */
+#line 187 "parser.y"
                       { (yyval.node) = (yyvsp[0].constant); }
-#line 1549 "parser.c"
+#line 1801 "parser.c"
     break;
 
-  case 23: /* return_val: map  */
-#line 113 "parser.y"
+  case 49: /* return_val: map  */
+#line 188 "parser.y"
                 { (yyval.node) = (yyvsp[0].node); }
-#line 1555 "parser.c"
+#line 1807 "parser.c"
     break;
 
-  case 24: /* update_stmt: UPDATE ID WITH map IN ID  */
-#line 115 "parser.y"
+  case 50: /* update_stmt: UPDATE ID WITH map IN ID  */
+#line 190 "parser.y"
                                       { (yyval.terminal) = new UpdateAction((yyvsp[-4].str), (MapNode*)(yyvsp[-2].node), (yyvsp[0].str)); }
-#line 1561 "parser.c"
+#line 1813 "parser.c"
     break;
 
-  case 25: /* remove_stmt: REMOVE ID IN ID  */
-#line 117 "parser.y"
+  case 51: /* remove_stmt: REMOVE ID IN ID  */
+#line 192 "parser.y"
                              { (yyval.terminal) = new RemoveAction((yyvsp[-2].str), (yyvsp[0].str)); }
-#line 1567 "parser.c"
+#line 1819 "parser.c"
     break;
 
-  case 26: /* map: LBRACE map_items RBRACE  */
-#line 119 "parser.y"
+  case 52: /* map: LBRACE map_items RBRACE  */
+#line 194 "parser.y"
                              { (yyval.node) = (yyvsp[-1].node); }
-#line 1573 "parser.c"
+#line 1825 "parser.c"
     break;
 
-  case 27: /* map: LBRACE RBRACE  */
-#line 120 "parser.y"
+  case 53: /* map: LBRACE RBRACE  */
+#line 195 "parser.y"
                     { (yyval.node) = new MapNode(); }
-#line 1579 "parser.c"
+#line 1831 "parser.c"
     break;
 
-  case 28: /* map_items: map_item  */
-#line 122 "parser.y"
+  case 54: /* map_items: map_item  */
+#line 197 "parser.y"
                              { MapNode* node = new MapNode(); node->addEntry((MapEntry*)(yyvsp[0].node)); (yyval.node) = node; }
-#line 1585 "parser.c"
+#line 1837 "parser.c"
     break;
 
-  case 29: /* map_items: map_item COMMA map_items  */
-#line 123 "parser.y"
+  case 55: /* map_items: map_item COMMA map_items  */
+#line 198 "parser.y"
                                      { ((MapNode*)(yyvsp[0].node))->addEntry((MapEntry*)(yyvsp[-2].node)); (yyval.node) = (yyvsp[0].node); }
-#line 1591 "parser.c"
+#line 1843 "parser.c"
     break;
 
-  case 30: /* map_item: STRING_TOKEN COLON constant  */
-#line 125 "parser.y"
+  case 56: /* map_item: STRING_TOKEN COLON constant  */
+#line 200 "parser.y"
                                       { (yyval.node) = new MapEntry((yyvsp[-2].str), (yyvsp[0].constant)); }
-#line 1597 "parser.c"
+#line 1849 "parser.c"
     break;
 
-  case 31: /* id: ID  */
-#line 127 "parser.y"
+  case 57: /* id: ID  */
+#line 202 "parser.y"
        { (yyval.constant) = new StringConstant((yyvsp[0].str), true); }
-#line 1603 "parser.c"
+#line 1855 "parser.c"
     break;
 
-  case 32: /* value: INT_TOKEN  */
-#line 129 "parser.y"
+  case 58: /* value: INT_TOKEN  */
+#line 204 "parser.y"
                  { (yyval.constant) = new IntConstant((yyvsp[0].intVal));}
-#line 1609 "parser.c"
+#line 1861 "parser.c"
     break;
 
-  case 33: /* value: FLOAT_TOKEN  */
-#line 130 "parser.y"
+  case 59: /* value: FLOAT_TOKEN  */
+#line 205 "parser.y"
                     { (yyval.constant) = new FloatConstant((yyvsp[0].floatVal));}
-#line 1615 "parser.c"
+#line 1867 "parser.c"
     break;
 
-  case 34: /* value: STRING_TOKEN  */
-#line 131 "parser.y"
+  case 60: /* value: STRING_TOKEN  */
+#line 206 "parser.y"
                      { (yyval.constant) = new StringConstant((yyvsp[0].str));}
-#line 1621 "parser.c"
+#line 1873 "parser.c"
     break;
 
-  case 35: /* value: BOOL_TOKEN  */
-#line 132 "parser.y"
+  case 61: /* value: BOOL_TOKEN  */
+#line 207 "parser.y"
                    { (yyval.constant) = new BoolConstant((yyvsp[0].boolVal));}
-#line 1627 "parser.c"
+#line 1879 "parser.c"
     break;
 
-  case 36: /* insert_stmt: INSERT map INTO ID  */
-#line 134 "parser.y"
+  case 62: /* insert_stmt: INSERT map INTO ID  */
+#line 209 "parser.y"
                                 { (yyval.node) = new InsertNode((MapNode*)(yyvsp[-2].node), (yyvsp[0].str)); }
-#line 1633 "parser.c"
+#line 1885 "parser.c"
     break;
 
-  case 37: /* create_stmt: CREATE TABLE ID map  */
-#line 136 "parser.y"
+  case 63: /* create_stmt: CREATE TABLE ID map  */
+#line 211 "parser.y"
                                  { (yyval.node) = new CreateTableNode((yyvsp[-1].str), (MapNode*)(yyvsp[0].node)); }
-#line 1639 "parser.c"
+#line 1891 "parser.c"
+    break;
+
+  case 64: /* create_stmt: CREATE INDEX ON ID LPAREN ID RPAREN  */
+#line 212 "parser.y"
+                                                  { (yyval.node) = new CreateIndexNode((yyvsp[-3].str), (yyvsp[-1].str)); }
+#line 1897 "parser.c"
     break;
 
-  case 38: /* drop_stmt: DROP TABLE ID  */
-#line 138 "parser.y"
+  case 65: /* drop_stmt: DROP TABLE ID  */
+#line 214 "parser.y"
                          { (yyval.node) = new DropTableNode((yyvsp[0].str)); }
-#line 1645 "parser.c"
+#line 1903 "parser.c"
     break;
 
 
-#line 1649 "parser.c"
+#line 1907 "parser.c"
 
       default: break;
     }
@@ -1719,7 +1977,7 @@ yyerrlab:
                 yysyntax_error_status = YYENOMEM;
               }
           }
-        yyerror (root, yymsgp);
+        yyerror (scanner, root, yymsgp);
         if (yysyntax_error_status == YYENOMEM)
           YYNOMEM;
       }
@@ -1739,7 +1997,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval, root);
+                      yytoken, &yylval, scanner, root);
           yychar = YYEMPTY;
         }
     }
@@ -1795,7 +2053,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  YY_ACCESSING_SYMBOL (yystate), yyvsp, root);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, scanner, root);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1833,7 +2091,7 @@ yyabortlab:
 | yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
 `-----------------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (root, YY_("memory exhausted"));
+  yyerror (scanner, root, YY_("memory exhausted"));
   yyresult = 2;
   goto yyreturnlab;
 
@@ -1848,7 +2106,7 @@ yyreturnlab:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval, root);
+                  yytoken, &yylval, scanner, root);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -1857,7 +2115,7 @@ yyreturnlab:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, root);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, scanner, root);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -1869,5 +2127,5 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 140 "parser.y"
-
+#line 216 "parser.y"
+
@@ -44,6 +44,12 @@
 #if YYDEBUG
 extern int yydebug;
 #endif
+/* "%code requires" blocks.  */
+#line 10 "parser.y"
+
+typedef void* yyscan_t;
+
+#line 53 "parser.h"
 
 /* Token kinds.  */
 #ifndef YYTOKENTYPE
@@ -63,22 +69,35 @@ extern int yydebug;
     IN = 264,                      /* IN  */
     FILTER = 265,                  /* FILTER  */
     RETURN = 266,                  /* RETURN  */
-    INSERT = 267,                  /* INSERT  */
-    INTO = 268,                    /* INTO  */
-    LPAREN = 269,                  /* LPAREN  */
-    RPAREN = 270,                  /* RPAREN  */
-    COLON = 271,                   /* COLON  */
-    LBRACE = 272,                  /* LBRACE  */
-    RBRACE = 273,                  /* RBRACE  */
-    LOGIC_OP = 274,                /* LOGIC_OP  */
-    COMP_OP = 275,                 /* COMP_OP  */
-    COMMA = 276,                   /* COMMA  */
-    UPDATE = 277,                  /* UPDATE  */
-    WITH = 278,                    /* WITH  */
-    REMOVE = 279,                  /* REMOVE  */
-    CREATE = 280,                  /* CREATE  */
-    DROP = 281,                    /* DROP  */
-    TABLE = 282                    /* TABLE  */
+    LIMIT = 267,                   /* LIMIT  */
+    SORT = 268,                    /* SORT  */
+    ASC = 269,                     /* ASC  */
+    DESC = 270,                    /* DESC  */
+    COLLECT = 271,                 /* COLLECT  */
+    AGGREGATE = 272,               /* AGGREGATE  */
+    ASSIGN = 273,                  /* ASSIGN  */
+    AGG_FUNC = 274,                /* AGG_FUNC  */
+    INSERT = 275,                  /* INSERT  */
+    INTO = 276,                    /* INTO  */
+    LPAREN = 277,                  /* LPAREN  */
+    RPAREN = 278,                  /* RPAREN  */
+    COLON = 279,                   /* COLON  */
+    LBRACE = 280,                  /* LBRACE  */
+    RBRACE = 281,                  /* RBRACE  */
+    LBRACKET = 282,                /* LBRACKET  */
+    RBRACKET = 283,                /* RBRACKET  */
+    OR_OP = 284,                   /* OR_OP  */
+    AND_OP = 285,                  /* AND_OP  */
+    COMP_OP = 286,                 /* COMP_OP  */
+    COMMA = 287,                   /* COMMA  */
+    UPDATE = 288,                  /* UPDATE  */
+    WITH = 289,                    /* WITH  */
+    REMOVE = 290,                  /* REMOVE  */
+    CREATE = 291,                  /* CREATE  */
+    DROP = 292,                    /* DROP  */
+    TABLE = 293,                   /* TABLE  */
+    INDEX = 294,                   /* INDEX  */
+    ON = 295                       /* ON  */
   };
   typedef enum yytokentype yytoken_kind_t;
 #endif
@@ -87,23 +106,26 @@ extern int yydebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 22 "parser.y"
-
-  const char* str;
-  float floatVal;
-  int intVal;
-  bool boolVal;
-
-  LogicalOp logicOp;
-  ConstantOperation compOp;
-
-  Node* node;
-  Predicate* predicate;
-  TerminalAction* terminal;
-  ActionNode* action;
-  Constant* constant;
-
-#line 107 "parser.h"
+#line 29 "parser.y"
+
+  const char* str;
+  float floatVal;
+  int intVal;
+  bool boolVal;
+
+  ConstantOperation compOp;
+  AggregateFunction aggFunc;
+
+  Node* node;
+  Predicate* predicate;
+  InCondition* inCondition;
+  SortNode* sort;
+  CollectNode* collect;
+  TerminalAction* terminal;
+  ActionNode* action;
+  Constant* constant;
+
+#line 129 "parser.h"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -112,10 +134,9 @@ typedef union YYSTYPE YYSTYPE;
 #endif
 
 
-extern YYSTYPE yylval;
 
 
-int yyparse (NodeWrapper& root);
+int yyparse (yyscan_t scanner, NodeWrapper& root);
 
 
 #endif /* !YY_YY_PARSER_H_INCLUDED  */
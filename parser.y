@@ -1,140 +1,216 @@
-%{
-#include <iostream>
-#include <list>
-#include "ast.h"
-
-extern int yylex();
-
-void yyerror(NodeWrapper& node, const char *s){
-  extern int yylineno;
-  std::cerr << yylineno << ": error: " << s << std::endl;
-}
-
-
-int temp = 0;
-
-%}
-
-%define parse.error verbose
-
-%parse-param { NodeWrapper& root }
-
-%union {
-  const char* str;
-  float floatVal;
-  int intVal;
-  bool boolVal;
-
-  LogicalOp logicOp;
-  ConstantOperation compOp;
-
-  Node* node;
-  Predicate* predicate;
-  TerminalAction* terminal;
-  ActionNode* action;
-  Constant* constant;
-}
-
-%token<str> ID
-%token<str> STRING_TOKEN
-%token<boolVal> BOOL_TOKEN
-%token<intVal> INT_TOKEN
-%token<floatVal> FLOAT_TOKEN
-%token FOR
-%token IN
-%token FILTER
-%token RETURN
-%token INSERT
-%token INTO
-%token LPAREN
-%token RPAREN
-%token COLON
-%token LBRACE
-%token RBRACE
-%token<logicOp> LOGIC_OP
-%token<compOp> COMP_OP
-%token COMMA
-%token UPDATE
-%token WITH
-%token REMOVE
-%token CREATE
-%token DROP
-%token TABLE
-
-%type<node> for_stmt action return_val map map_items map_item insert_stmt filter_stmt create_stmt drop_stmt
-%type<terminal> terminal_stmt return_stmt update_stmt remove_stmt
-%type<predicate> conditions condition
-%type<action> actions
-%type<constant> constant id value
-
-%left LOGIC_OP
-%left COMP_OP
-%left IN
-%left WITH
-%left INTO
-%left RETURN
-
-%%
-
-query: for_stmt  { root.node = $1;  }
-      | insert_stmt { root.node = $1; }
-      | create_stmt { root.node = $1; }
-      | drop_stmt { root.node = $1; }
-
-for_stmt: FOR ID IN ID actions { $$ = new ForNode($2, $4, $5); }
-
-actions: actions action { $$ = $1; $1->addAction($2); } 
-        | action { $$ = new ActionNode(); $$->addAction($1); }
-
-action: for_stmt { $$ = $1; } 
-      | filter_stmt { $$ = $1; }
-      | terminal_stmt  { $$ = $1; }
-
-terminal_stmt: return_stmt { $$ = $1; }
-              | update_stmt { $$ = $1; }
-              | remove_stmt { $$ = $1; }
-
-filter_stmt: FILTER conditions { $$ = new FilterNode($2); }
-
-
-conditions: condition                      { $$ = $1; }
-          | conditions LOGIC_OP conditions { $$ = new ConditionUnion($2, $1, $3); }
-
-condition: constant COMP_OP constant {
-                                        $$ = new Condition($1, $3, $2);
-                                        }
-
-constant: id | value  { $$ = $1; }
-
-
-return_stmt: RETURN return_val { $$ = new ReturnAction($2); }
-
-return_val: constant  { $$ = $1; }
-          | map { $$ = $1; }
-
-update_stmt: UPDATE ID WITH map IN ID { $$ = new UpdateAction($2, (MapNode*)$4, $6); }
-
-remove_stmt: REMOVE ID IN ID { $$ = new RemoveAction($2, $4); }
-
-map: LBRACE map_items RBRACE { $$ = $2; }
-    | LBRACE RBRACE { $$ = new MapNode(); }
-
-map_items: map_item          { MapNode* node = new MapNode(); node->addEntry((MapEntry*)$1); $$ = node; }
-          | map_item COMMA map_items { ((MapNode*)$3)->addEntry((MapEntry*)$1); $$ = $3; }
-
-map_item: STRING_TOKEN COLON constant { $$ = new MapEntry($1, $3); }
-
-id: ID { $$ = new StringConstant($1, true); }
-
-value: INT_TOKEN { $$ = new IntConstant($1);}
-      | FLOAT_TOKEN { $$ = new FloatConstant($1);}
-      | STRING_TOKEN { $$ = new StringConstant($1);}
-      | BOOL_TOKEN { $$ = new BoolConstant($1);}
-
-insert_stmt: INSERT map INTO ID { $$ = new InsertNode((MapNode*)$2, $4); }
-
-create_stmt: CREATE TABLE ID map { $$ = new CreateTableNode($3, (MapNode*)$4); };
-
-drop_stmt: DROP TABLE ID { $$ = new DropTableNode($3); }
-
-%%
+%{
+#include <iostream>
+#include <list>
+#include "ast.h"
+
+int temp = 0;
+
+%}
+
+%code requires {
+typedef void* yyscan_t;
+}
+
+%code {
+extern int yylex(YYSTYPE* lvalp, yyscan_t scanner);
+extern int yyget_lineno(yyscan_t scanner);
+
+void yyerror(yyscan_t scanner, NodeWrapper& node, const char *s){
+  std::cerr << yyget_lineno(scanner) << ": error: " << s << std::endl;
+}
+}
+
+%define parse.error verbose
+%define api.pure full
+
+%lex-param { yyscan_t scanner }
+%parse-param { yyscan_t scanner } { NodeWrapper& root }
+
+%union {
+  const char* str;
+  float floatVal;
+  int intVal;
+  bool boolVal;
+
+  ConstantOperation compOp;
+  AggregateFunction aggFunc;
+
+  Node* node;
+  Predicate* predicate;
+  InCondition* inCondition;
+  SortNode* sort;
+  CollectNode* collect;
+  TerminalAction* terminal;
+  ActionNode* action;
+  Constant* constant;
+}
+
+%token<str> ID
+%token<str> STRING_TOKEN
+%token<boolVal> BOOL_TOKEN
+%token<intVal> INT_TOKEN
+%token<floatVal> FLOAT_TOKEN
+%token FOR
+%token IN
+%token FILTER
+%token RETURN
+%token LIMIT
+%token SORT
+%token ASC
+%token DESC
+%token COLLECT
+%token AGGREGATE
+%token ASSIGN
+%token<aggFunc> AGG_FUNC
+%token INSERT
+%token INTO
+%token LPAREN
+%token RPAREN
+%token COLON
+%token LBRACE
+%token RBRACE
+%token LBRACKET
+%token RBRACKET
+%token OR_OP
+%token AND_OP
+%token<compOp> COMP_OP
+%token COMMA
+%token UPDATE
+%token WITH
+%token REMOVE
+%token CREATE
+%token DROP
+%token TABLE
+%token INDEX
+%token ON
+
+%type<node> for_stmt action return_val map map_items map_item insert_stmt filter_stmt limit_stmt create_stmt drop_stmt
+%type<terminal> terminal_stmt return_stmt update_stmt remove_stmt
+%type<predicate> conditions condition
+%type<inCondition> in_list in_items
+%type<sort> sort_stmt sort_keys
+%type<boolVal> sort_direction
+%type<collect> collect_stmt collect_groups collect_aggregates
+%type<constant> aggregate_argument
+%type<action> actions
+%type<constant> constant id value
+
+%left OR_OP
+%left AND_OP
+%left COMP_OP
+%left IN
+%left WITH
+%left INTO
+%left RETURN
+
+%%
+
+query: for_stmt  { root.node = $1;  }
+      | insert_stmt { root.node = $1; }
+      | create_stmt { root.node = $1; }
+      | drop_stmt { root.node = $1; }
+
+for_stmt: FOR ID IN ID actions { $$ = new ForNode($2, $4, $5); }
+
+actions: actions action { $$ = $1; $1->addAction($2); } 
+        | action { $$ = new ActionNode(); $$->addAction($1); }
+
+action: for_stmt { $$ = $1; } 
+      | filter_stmt { $$ = $1; }
+      | limit_stmt { $$ = $1; }
+      | sort_stmt { $$ = $1; }
+      | collect_stmt { $$ = $1; }
+      | terminal_stmt  { $$ = $1; }
+
+terminal_stmt: return_stmt { $$ = $1; }
+              | update_stmt { $$ = $1; }
+              | remove_stmt { $$ = $1; }
+
+filter_stmt: FILTER conditions { $$ = new FilterNode(ConditionUnion::foldMembership($2)); }
+
+limit_stmt: LIMIT INT_TOKEN {
+                                if ($2 < 0) { yyerror(scanner, root, "LIMIT count must not be negative"); YYERROR; }
+                                $$ = new LimitNode(0, $2);
+                                }
+          | LIMIT INT_TOKEN COMMA INT_TOKEN {
+                                if ($2 < 0 || $4 < 0) { yyerror(scanner, root, "LIMIT offset and count must not be negative"); YYERROR; }
+                                $$ = new LimitNode($2, $4);
+                                }
+
+sort_stmt: SORT sort_keys { $$ = $2; }
+
+sort_keys: id sort_direction { $$ = new SortNode(); $$->addKey($1, $2); }
+          | sort_keys COMMA id sort_direction { $$ = $1; $1->addKey($3, $4); }
+
+sort_direction: %empty { $$ = false; }
+              | ASC { $$ = false; }
+              | DESC { $$ = true; }
+
+collect_stmt: collect_groups { $$ = $1; }
+            | collect_aggregates { $$ = $1; }
+
+collect_groups: COLLECT ID ASSIGN constant { $$ = new CollectNode(); $$->addGroup($2, $4); }
+              | collect_groups COMMA ID ASSIGN constant { $$ = $1; $1->addGroup($3, $5); }
+
+collect_aggregates: collect_groups AGGREGATE ID ASSIGN AGG_FUNC aggregate_argument { $$ = $1; $1->addAggregate($3, $5, $6); }
+                  | COLLECT AGGREGATE ID ASSIGN AGG_FUNC aggregate_argument { $$ = new CollectNode(); $$->addAggregate($3, $5, $6); }
+                  | collect_aggregates COMMA ID ASSIGN AGG_FUNC aggregate_argument { $$ = $1; $1->addAggregate($3, $5, $6); }
+
+// Always preceded by AGG_FUNC, which $<aggFunc>0 reads.
+aggregate_argument: LPAREN RPAREN {
+                                if ($<aggFunc>0 != COUNT) { yyerror(scanner, root, "only COUNT can be called without an argument"); YYERROR; }
+                                $$ = nullptr;
+                                }
+                  | LPAREN constant RPAREN { $$ = $2; }
+
+
+conditions: condition                      { $$ = $1; }
+          | conditions OR_OP conditions    { $$ = ConditionUnion::combine(OR, $1, $3); }
+          | conditions AND_OP conditions   { $$ = ConditionUnion::combine(AND, $1, $3); }
+
+condition: constant COMP_OP constant {
+                                        $$ = new Condition($1, $3, $2);
+                                        }
+          | constant IN in_list { $3->setValue($1); $$ = $3; }
+
+in_list: LBRACKET in_items RBRACKET { $$ = $2; }
+        | LBRACKET RBRACKET { $$ = new InCondition(); }
+
+in_items: value { $$ = new InCondition(); $$->addValue($1); }
+        | in_items COMMA value { $$ = $1; $1->addValue($3); }
+
+constant: id | value  { $$ = $1; }
+
+
+return_stmt: RETURN return_val { $$ = new ReturnAction($2); }
+
+return_val: constant  { $$ = $1; }
+          | map { $$ = $1; }
+
+update_stmt: UPDATE ID WITH map IN ID { $$ = new UpdateAction($2, (MapNode*)$4, $6); }
+
+remove_stmt: REMOVE ID IN ID { $$ = new RemoveAction($2, $4); }
+
+map: LBRACE map_items RBRACE { $$ = $2; }
+    | LBRACE RBRACE { $$ = new MapNode(); }
+
+map_items: map_item          { MapNode* node = new MapNode(); node->addEntry((MapEntry*)$1); $$ = node; }
+          | map_item COMMA map_items { ((MapNode*)$3)->addEntry((MapEntry*)$1); $$ = $3; }
+
+map_item: STRING_TOKEN COLON constant { $$ = new MapEntry($1, $3); }
+
+id: ID { $$ = new StringConstant($1, true); }
+
+value: INT_TOKEN { $$ = new IntConstant($1);}
+      | FLOAT_TOKEN { $$ = new FloatConstant($1);}
+      | STRING_TOKEN { $$ = new StringConstant($1);}
+      | BOOL_TOKEN { $$ = new BoolConstant($1);}
+
+insert_stmt: INSERT map INTO ID { $$ = new InsertNode((MapNode*)$2, $4); }
+
+create_stmt: CREATE TABLE ID map { $$ = new CreateTableNode($3, (MapNode*)$4); }
+            | CREATE INDEX ON ID LPAREN ID RPAREN { $$ = new CreateIndexNode($4, $6); };
+
+drop_stmt: DROP TABLE ID { $$ = new DropTableNode($3); }
+
+%%
@@ -0,0 +1,938 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <set>
+#include <string>
+#include <utility>
+#include "planner.h"
+
+// ------------------------------------------ BloomFilter ------------------------------------------
+
+// 8 bits per row of a full block and 3 probes give about 3% false positives.
+static const size_t bloomBits = blockRows * 8;
+static const int bloomProbes = 3;
+
+BloomFilter::BloomFilter() : bits(bloomBits / 64) {}
+
+void BloomFilter::add(const std::string& key) {
+    uint64_t hash = std::hash<std::string>()(key);
+    uint64_t step = (hash >> 32) | 1;
+    for (int i = 0; i < bloomProbes; i++) {
+        uint64_t bit = (hash + i * step) % bloomBits;
+        this->bits[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+}
+
+bool BloomFilter::mayContain(const std::string& key) {
+    uint64_t hash = std::hash<std::string>()(key);
+    uint64_t step = (hash >> 32) | 1;
+    for (int i = 0; i < bloomProbes; i++) {
+        uint64_t bit = (hash + i * step) % bloomBits;
+        if ((this->bits[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ------------------------------------------ Catalog ------------------------------------------
+
+// Field name of a map key: `id` for `"id"`.
+static std::string getFieldName(const char* key) {
+    std::string field = key;
+    if (field.size() >= 2 && field.front() == '"' && field.back() == '"') {
+        field = field.substr(1, field.size() - 2);
+    }
+    return field;
+}
+
+static void trackSortedFields(TableStats& stats, MapNode* row) {
+    std::unordered_set<std::string> stillSorted;
+    for (auto entry : row->getEntries()) {
+        Constant* value = entry->getValue();
+        if (value->getType() != INT && value->getType() != FLOAT) {
+            continue;
+        }
+        std::string field = getFieldName(entry->getKey());
+        double number = value->getNumVal();
+        bool sorted = stats.rows == 0
+            || (stats.sortedFields.count(field) != 0 && stats.lastValues[field] <= number);
+        if (sorted) {
+            stillSorted.insert(field);
+        }
+        stats.lastValues[field] = number;
+    }
+    stats.sortedFields = stillSorted;
+}
+
+static const size_t maxDictionarySize = 256;
+
+static void trackDictionary(Dictionary& dictionary, Constant* value) {
+    if (dictionary.overflow) {
+        return;
+    }
+    if (value->getType() != STRING) {
+        dictionary.overflow = true;
+        dictionary.distinct.clear();
+        return;
+    }
+    if (dictionary.distinct.count(value->getStrVal()) == 0) {
+        if (dictionary.distinct.size() == maxDictionarySize) {
+            dictionary.overflow = true;
+            dictionary.distinct.clear();
+            return;
+        }
+        dictionary.distinct.insert(value->getStrVal());
+    }
+    dictionary.values++;
+}
+
+static void trackBlocks(TableStats& stats, MapNode* row) {
+    if (stats.blocks.empty() || stats.blocks.back().rows == blockRows) {
+        stats.blocks.emplace_back();
+    }
+    BlockStats& block = stats.blocks.back();
+    block.rows++;
+    for (auto entry : row->getEntries()) {
+        Constant* value = entry->getValue();
+        std::string field = getFieldName(entry->getKey());
+        block.blooms[field].add(value->getValueKey());
+        trackDictionary(block.dictionaries[field], value);
+        FieldZone& zone = block.zones[field];
+        if (value->getType() == STRING) {
+            zone.strings++;
+        }
+        if (value->getType() != INT && value->getType() != FLOAT) {
+            continue;
+        }
+        double number = value->getNumVal();
+        if (zone.values == 0 || number < zone.min) {
+            zone.min = number;
+        }
+        if (zone.values == 0 || number > zone.max) {
+            zone.max = number;
+        }
+        zone.values++;
+    }
+}
+
+static TableStats createTableStats(CreateTableNode* table) {
+    TableStats stats;
+    for (auto entry : table->getFields()->getEntries()) {
+        std::string type = entry->getValue()->getStrVal();
+        std::string field = getFieldName(entry->getKey());
+        if (type == "int") {
+            stats.fieldTypes[field] = INT;
+        } else if (type == "float") {
+            stats.fieldTypes[field] = FLOAT;
+        } else if (type == "bool") {
+            stats.fieldTypes[field] = BOOL;
+        } else if (type == "string") {
+            stats.fieldTypes[field] = STRING;
+        }
+    }
+    return stats;
+}
+
+// Fields an UPDATE really changes: `x.a` written back to `a` is left out.
+static std::set<std::string> getWriteSet(UpdateAction* update) {
+    std::string self = std::string(update->getVariable()) + ".";
+    std::set<std::string> writeSet;
+    for (auto entry : update->getValue()->getEntries()) {
+        std::string field = getFieldName(entry->getKey());
+        Constant* value = entry->getValue();
+        if (value->getType() == REF && value->getStrVal() == self + field) {
+            continue;
+        }
+        writeSet.insert(field);
+    }
+    return writeSet;
+}
+
+// Forgets what the blocks of every table updated below loop knew about the
+// written fields, since any row of the table may now hold any value there.
+// For the same reason those fields no longer count as sorted.
+void Catalog::applyUpdates(ForNode* loop) {
+    if (loop->getAction() == nullptr) {
+        return;
+    }
+    for (auto action : ((ActionNode*)loop->getAction())->getActions()) {
+        if (action->getNodeType() == FOR_NODE) {
+            applyUpdates((ForNode*)action);
+            continue;
+        }
+        if (action->getNodeType() != UPDATE_NODE) {
+            continue;
+        }
+        UpdateAction* update = (UpdateAction*)action;
+        TableStats* stats = find(update->getTable());
+        if (stats == nullptr) {
+            continue;
+        }
+        for (auto& field : getWriteSet(update)) {
+            for (auto& block : stats->blocks) {
+                block.zones.erase(field);
+                block.blooms.erase(field);
+                block.dictionaries.erase(field);
+                block.unknownFields.insert(field);
+            }
+            stats->sortedFields.erase(field);
+        }
+    }
+}
+
+void Catalog::apply(Node* query) {
+    switch (query->getNodeType()) {
+        case CREATE_TABLE_NODE:
+            this->tables[((CreateTableNode*)query)->getTable()] = createTableStats((CreateTableNode*)query);
+            break;
+        case CREATE_INDEX_NODE: {
+            CreateIndexNode* index = (CreateIndexNode*)query;
+            this->tables[index->getTable()].indexes.insert(index->getField());
+            break;
+        }
+        case INSERT_NODE: {
+            InsertNode* insert = (InsertNode*)query;
+            TableStats& stats = this->tables[insert->getTable()];
+            trackSortedFields(stats, insert->getMap());
+            trackBlocks(stats, insert->getMap());
+            stats.rows++;
+            break;
+        }
+        case FOR_NODE:
+            applyUpdates((ForNode*)query);
+            break;
+        case DROP_TABLE_NODE:
+            this->tables.erase(((DropTableNode*)query)->getTable());
+            break;
+        default:
+            break;
+    }
+}
+
+TableStats* Catalog::find(const char* table) {
+    auto it = this->tables.find(table);
+    return it == this->tables.end() ? nullptr : &it->second;
+}
+
+// ------------------------------------------ Planner ------------------------------------------
+
+// Row count assumed for tables the catalog knows nothing about.
+static const double defaultRows = 1000;
+// Hash joins whose build side is larger than this are too memory hungry.
+static const double maxHashBuildRows = 1000000;
+// Build rows per hash join partition, so each partition's table stays in cache.
+static const double rowsPerPartition = 65536;
+
+// Loop variable a reference belongs to: `x` for `x.id`.
+static std::string getRefVariable(Constant* ref) {
+    std::string value = ref->getStrVal();
+    return value.substr(0, value.find('.'));
+}
+
+// Field a reference points to: `id` for `x.id`.
+static std::string getRefField(const std::string& ref) {
+    return ref.substr(ref.find('.') + 1);
+}
+
+static double getRows(TableStats* stats) {
+    return stats != nullptr ? std::max<double>(stats->rows, 1) : defaultRows;
+}
+
+static bool isSortedOn(TableStats* stats, const std::string& ref) {
+    return stats != nullptr && stats->sortedFields.count(getRefField(ref)) != 0;
+}
+
+static bool isIndexedOn(TableStats* stats, const std::string& ref) {
+    return stats != nullptr && stats->indexes.count(getRefField(ref)) != 0;
+}
+
+static double getSortCost(double rows) {
+    return rows * std::log2(rows + 1);
+}
+
+// Partitions are a power of two so rows can be split on the low hash bits.
+static int getPartitionCount(double buildRows) {
+    int partitions = 1;
+    while (partitions * rowsPerPartition < buildRows) {
+        partitions *= 2;
+    }
+    return partitions;
+}
+
+static bool isFieldRef(Constant* constant) {
+    return constant->getType() == REF && constant->getStrVal().find('.') != std::string::npos;
+}
+
+static ForNode* findLoop(std::list<ForNode*>& loops, const std::string& variable) {
+    for (auto loop : loops) {
+        if (variable == loop->getVariable()) {
+            return loop;
+        }
+    }
+    return nullptr;
+}
+
+// True for actions a FILTER or LIMIT after them cannot be planned as if it ran
+// on the loop's own rows: LIMIT, SORT and COLLECT cut, reorder or group the
+// stream, and RETURN, UPDATE and REMOVE have already emitted or written a row
+// before anything after them runs.
+static bool isPipelineBreaker(Node* action) {
+    switch (action->getNodeType()) {
+        case LIMIT_NODE:
+        case SORT_NODE:
+        case COLLECT_NODE:
+        case RETURN_NODE:
+        case UPDATE_NODE:
+        case REMOVE_NODE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Matches `outer.a == inner.b` (in either order) and fills the join keys.
+static ForNode* matchJoinCondition(Predicate* predicate, ForNode* inner, std::list<ForNode*>& outer, JoinPlan& plan) {
+    if (predicate->getNodeType() != CONDITION_NODE) {
+        return nullptr;
+    }
+    Condition* condition = (Condition*)predicate;
+    if (condition->getOperation() != EQ || !isFieldRef(condition->getLeft()) || !isFieldRef(condition->getRight())) {
+        return nullptr;
+    }
+    Constant* innerRef = condition->getLeft();
+    Constant* outerRef = condition->getRight();
+    if (getRefVariable(innerRef) != inner->getVariable()) {
+        std::swap(innerRef, outerRef);
+    }
+    if (getRefVariable(innerRef) != inner->getVariable()) {
+        return nullptr;
+    }
+    ForNode* outerLoop = findLoop(outer, getRefVariable(outerRef));
+    if (outerLoop == nullptr) {
+        return nullptr;
+    }
+    plan.outerKey = outerRef->getStrVal();
+    plan.innerKey = innerRef->getStrVal();
+    return outerLoop;
+}
+
+static ForNode* findJoinCondition(ForNode* inner, std::list<ForNode*>& outer, JoinPlan& plan) {
+    if (inner->getAction() == nullptr) {
+        return nullptr;
+    }
+    for (auto action : ((ActionNode*)inner->getAction())->getActions()) {
+        if (isPipelineBreaker(action)) {
+            break;
+        }
+        if (action->getNodeType() != FILTER_NODE) {
+            continue;
+        }
+        Predicate* predicate = ((FilterNode*)action)->getPredicate();
+        if (predicate->getNodeType() == CONDITION_UNION_NODE) {
+            ConditionUnion* conjunction = (ConditionUnion*)predicate;
+            if (conjunction->getOperator() != AND) {
+                continue;
+            }
+            for (auto operand : conjunction->getOperands()) {
+                ForNode* outerLoop = matchJoinCondition(operand, inner, outer, plan);
+                if (outerLoop != nullptr) {
+                    return outerLoop;
+                }
+            }
+        } else {
+            ForNode* outerLoop = matchJoinCondition(predicate, inner, outer, plan);
+            if (outerLoop != nullptr) {
+                return outerLoop;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// Chooses how to execute a nested loop with an equality on outer and inner
+// fields, using row counts, indexes and sort order known to the catalog:
+//   nested loop        outer * inner
+//   hash               2 * build + probe, build on the smaller side
+//   index nested loop  outer * log(inner), needs an index on the inner key
+//   sort merge         outer + inner, plus sorting any side not already sorted
+static void planJoin(ForNode* inner, std::list<ForNode*>& outer, Catalog& catalog) {
+    JoinPlan plan;
+    ForNode* outerLoop = findJoinCondition(inner, outer, plan);
+    if (outerLoop == nullptr) {
+        return;
+    }
+    TableStats* outerStats = catalog.find(outerLoop->getTableName());
+    TableStats* innerStats = catalog.find(inner->getTableName());
+    double outerRows = getRows(outerStats);
+    double innerRows = getRows(innerStats);
+
+    plan.strategy = NESTED_LOOP_JOIN;
+    double bestCost = outerRows * innerRows;
+
+    double buildRows = std::min(outerRows, innerRows);
+    double hashCost = 2 * buildRows + std::max(outerRows, innerRows);
+    if (buildRows <= maxHashBuildRows && hashCost < bestCost) {
+        plan.strategy = HASH_JOIN;
+        plan.buildOuter = outerRows < innerRows;
+        plan.partitions = getPartitionCount(buildRows);
+        bestCost = hashCost;
+    }
+
+    if (isIndexedOn(innerStats, plan.innerKey)) {
+        double indexCost = outerRows * (std::log2(innerRows + 1) + 1);
+        if (indexCost < bestCost) {
+            plan.strategy = INDEX_NESTED_LOOP_JOIN;
+            bestCost = indexCost;
+        }
+    }
+
+    double mergeCost = outerRows + innerRows;
+    if (!isSortedOn(outerStats, plan.outerKey)) {
+        mergeCost += getSortCost(outerRows);
+    }
+    if (!isSortedOn(innerStats, plan.innerKey)) {
+        mergeCost += getSortCost(innerRows);
+    }
+    if (mergeCost < bestCost) {
+        plan.strategy = SORT_MERGE_JOIN;
+        bestCost = mergeCost;
+    }
+
+    inner->getJoin() = plan;
+}
+
+static bool isNumber(Constant* constant) {
+    return constant->getType() == INT || constant->getType() == FLOAT;
+}
+
+// True when no row of block can satisfy `ref op value`. Values order as
+// null < bool < number < string, so rows without the field or with a bool
+// only count as matches for < <= and !=, and strings for > >= and !=.
+static bool zoneExcludes(BlockStats& block, const std::string& field, ConstantOperation op, double value) {
+    auto found = block.zones.find(field);
+    FieldZone zone = found != block.zones.end() ? found->second : FieldZone();
+    bool hasLower = zone.values + zone.strings < block.rows;
+    if (hasLower && (op == LT || op == LTE || op == NEQ)) {
+        return false;
+    }
+    if (zone.strings > 0 && (op == GT || op == GTE || op == NEQ)) {
+        return false;
+    }
+    if (zone.values == 0) {
+        return true;
+    }
+    switch (op) {
+        case EQ:
+            return value < zone.min || value > zone.max;
+        case NEQ:
+            return zone.min == value && zone.max == value;
+        case GT:
+            return zone.max <= value;
+        case GTE:
+            return zone.max < value;
+        case LT:
+            return zone.min >= value;
+        case LTE:
+            return zone.min > value;
+        default:
+            return false;
+    }
+}
+
+// String literal without its quotes.
+static std::string unquote(const std::string& value) {
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+        return value.substr(1, value.size() - 2);
+    }
+    return value;
+}
+
+// Evaluates `field op literal` once per distinct value of the field in the
+// block instead of once per row. LIKE tests for a substring.
+static bool dictionaryExcludes(BlockStats& block, const std::string& field, ConstantOperation op, Constant* literal) {
+    auto found = block.dictionaries.find(field);
+    if (found == block.dictionaries.end() || found->second.overflow || literal->getType() != STRING) {
+        return false;
+    }
+    Dictionary& dictionary = found->second;
+    bool hasNulls = dictionary.values < block.rows;
+    std::string pattern = unquote(literal->getStrVal());
+    for (auto& value : dictionary.distinct) {
+        bool matches = false;
+        switch (op) {
+            case EQ:
+                matches = value == literal->getStrVal();
+                break;
+            case NEQ:
+                matches = value != literal->getStrVal();
+                break;
+            case LIKE:
+                matches = unquote(value).find(pattern) != std::string::npos;
+                break;
+            default:
+                return false;
+        }
+        if (matches) {
+            return false;
+        }
+    }
+    return !(hasNulls && op == NEQ);
+}
+
+// True when no row of block can satisfy `field op literal`, judged by the
+// zone map for numbers, the dictionary for strings and the Bloom filter
+// for equality.
+static bool literalExcludes(BlockStats& block, const std::string& field, ConstantOperation op, Constant* literal) {
+    if (block.unknownFields.count(field) != 0) {
+        return false;
+    }
+    if (isNumber(literal) && zoneExcludes(block, field, op, literal->getNumVal())) {
+        return true;
+    }
+    if (dictionaryExcludes(block, field, op, literal)) {
+        return true;
+    }
+    if (op == EQ) {
+        auto bloom = block.blooms.find(field);
+        return bloom == block.blooms.end() || !bloom->second.mayContain(literal->getValueKey());
+    }
+    return false;
+}
+
+// `literal op x.f` is the same test as `x.f op' literal`.
+static ConstantOperation mirrorOperation(ConstantOperation op) {
+    switch (op) {
+        case GT:
+            return LT;
+        case LT:
+            return GT;
+        case GTE:
+            return LTE;
+        case LTE:
+            return GTE;
+        default:
+            return op;
+    }
+}
+
+static bool isVariableField(Constant* constant, const std::string& variable) {
+    return isFieldRef(constant) && getRefVariable(constant) == variable;
+}
+
+// True when the block statistics prove no row of block can satisfy predicate.
+static bool blockExcludes(BlockStats& block, Predicate* predicate, const std::string& variable) {
+    switch (predicate->getNodeType()) {
+        case CONDITION_NODE: {
+            Condition* condition = (Condition*)predicate;
+            if (isVariableField(condition->getLeft(), variable) && condition->getRight()->getType() != REF) {
+                return literalExcludes(block, getRefField(condition->getLeft()->getStrVal()), condition->getOperation(),
+                                       condition->getRight());
+            }
+            // LIKE is not symmetric: `"abc" LIKE x.name` has the pattern on the field side.
+            if (isVariableField(condition->getRight(), variable) && condition->getLeft()->getType() != REF &&
+                condition->getOperation() != LIKE) {
+                return literalExcludes(block, getRefField(condition->getRight()->getStrVal()),
+                                       mirrorOperation(condition->getOperation()), condition->getLeft());
+            }
+            return false;
+        }
+        case CONDITION_IN_NODE: {
+            InCondition* in = (InCondition*)predicate;
+            if (!isVariableField(in->getValue(), variable)) {
+                return false;
+            }
+            std::string field = getRefField(in->getValue()->getStrVal());
+            auto dictionary = block.dictionaries.find(field);
+            if (block.unknownFields.count(field) == 0 && dictionary != block.dictionaries.end() &&
+                !dictionary->second.overflow) {
+                // Every value the block holds for the field is one of these
+                // strings, so one lookup in the list's set per string decides.
+                for (auto& value : dictionary->second.distinct) {
+                    if (in->containsString(value)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            for (auto value : in->getValues()) {
+                if (!literalExcludes(block, field, EQ, value)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case CONDITION_UNION_NODE: {
+            ConditionUnion* node = (ConditionUnion*)predicate;
+            for (auto operand : node->getOperands()) {
+                bool excludes = blockExcludes(block, operand, variable);
+                if (node->getOperator() == AND && excludes) {
+                    return true;
+                }
+                if (node->getOperator() == OR && !excludes) {
+                    return false;
+                }
+            }
+            return node->getOperator() == OR;
+        }
+        default:
+            return false;
+    }
+}
+
+// Counts the blocks a scan still has to read once blocks whose statistics
+// rule out one of the loop's FILTERs are skipped. Only FILTERs ahead of the
+// first pipeline breaker apply, since skipping rows earlier would change
+// what that sees or emits.
+static void planBlockSkipping(ForNode* node, Catalog& catalog) {
+    TableStats* stats = catalog.find(node->getTableName());
+    if (stats == nullptr || stats->blocks.empty() || node->getAction() == nullptr) {
+        return;
+    }
+    std::list<Predicate*> filters;
+    for (auto action : ((ActionNode*)node->getAction())->getActions()) {
+        if (isPipelineBreaker(action)) {
+            break;
+        }
+        if (action->getNodeType() == FILTER_NODE) {
+            filters.push_back(((FilterNode*)action)->getPredicate());
+        }
+    }
+    int scanned = 0;
+    for (auto& block : stats->blocks) {
+        bool skip = false;
+        for (auto predicate : filters) {
+            if (blockExcludes(block, predicate, node->getVariable())) {
+                skip = true;
+                break;
+            }
+        }
+        if (!skip) {
+            scanned++;
+        }
+    }
+    node->setBlocks(scanned, stats->blocks.size());
+}
+
+static bool isNumericField(Constant* ref, std::list<ForNode*>& scope, Catalog& catalog) {
+    if (!isFieldRef(ref)) {
+        return false;
+    }
+    ForNode* loop = findLoop(scope, getRefVariable(ref));
+    TableStats* stats = loop != nullptr ? catalog.find(loop->getTableName()) : nullptr;
+    if (stats == nullptr) {
+        return false;
+    }
+    auto type = stats->fieldTypes.find(getRefField(ref->getStrVal()));
+    return type != stats->fieldTypes.end() && type->second != STRING;
+}
+
+// A SORT directly followed by LIMIT only has to keep the best offset + count
+// rows in a bounded heap. Otherwise keys declared numeric in CREATE TABLE can
+// be radix sorted, and anything else falls back to a comparison sort.
+static void planSort(SortNode* sort, Node* next, std::list<ForNode*>& scope, Catalog& catalog) {
+    if (next != nullptr && next->getNodeType() == LIMIT_NODE) {
+        LimitNode* limit = (LimitNode*)next;
+        sort->setAlgorithm(TOP_K_SORT, std::max(limit->getOffset(), 0) + std::max(limit->getCount(), 0));
+        return;
+    }
+    for (auto key : sort->getKeys()) {
+        if (!isNumericField(key.value, scope, catalog)) {
+            sort->setAlgorithm(COMPARISON_SORT);
+            return;
+        }
+    }
+    sort->setAlgorithm(RADIX_SORT);
+}
+
+// Without group keys there is a single aggregate state. Rows coming straight
+// from a SORT on the group keys arrive grouped and can be aggregated as a
+// stream; anything else goes through a hash table keyed by the group values.
+static void planCollect(CollectNode* collect, Node* previous) {
+    if (collect->getGroups().empty()) {
+        collect->setAlgorithm(SCALAR_AGGREGATION);
+        return;
+    }
+    if (previous != nullptr && previous->getNodeType() == SORT_NODE) {
+        std::list<SortKey>& keys = ((SortNode*)previous)->getKeys();
+        auto key = keys.begin();
+        bool grouped = true;
+        for (auto group : collect->getGroups()) {
+            if (key == keys.end() || key->value->getStrVal() != group.value->getStrVal()) {
+                grouped = false;
+                break;
+            }
+            ++key;
+        }
+        if (grouped) {
+            collect->setAlgorithm(SORTED_AGGREGATION);
+            return;
+        }
+    }
+    collect->setAlgorithm(HASH_AGGREGATION);
+}
+
+// Compiles the UPDATE map into the set of fields it changes, so rows can be
+// patched in place field by field. Assigning a field to itself changes
+// nothing and is left out. Indexes are only maintained for fields in the set.
+static void planUpdate(UpdateAction* update, Catalog& catalog) {
+    std::set<std::string> writeSet = getWriteSet(update);
+    std::set<std::string> indexUpdates;
+    TableStats* stats = catalog.find(update->getTable());
+    if (stats != nullptr) {
+        for (auto& field : writeSet) {
+            if (stats->indexes.count(field) != 0) {
+                indexUpdates.insert(field);
+            }
+        }
+    }
+    update->setWriteSet(writeSet, indexUpdates);
+}
+
+static void planFor(ForNode* node, std::list<ForNode*>& outer, Catalog& catalog) {
+    if (!outer.empty()) {
+        planJoin(node, outer, catalog);
+    }
+    planBlockSkipping(node, catalog);
+    if (node->getAction() == nullptr) {
+        return;
+    }
+    outer.push_back(node);
+    std::list<Node*>& actions = ((ActionNode*)node->getAction())->getActions();
+    for (auto it = actions.begin(); it != actions.end(); ++it) {
+        if ((*it)->getNodeType() == FOR_NODE) {
+            planFor((ForNode*)*it, outer, catalog);
+        } else if ((*it)->getNodeType() == SORT_NODE) {
+            auto next = std::next(it);
+            planSort((SortNode*)*it, next != actions.end() ? *next : nullptr, outer, catalog);
+        } else if ((*it)->getNodeType() == COLLECT_NODE) {
+            planCollect((CollectNode*)*it, it != actions.begin() ? *std::prev(it) : nullptr);
+        } else if ((*it)->getNodeType() == UPDATE_NODE) {
+            planUpdate((UpdateAction*)*it, catalog);
+        }
+    }
+    outer.pop_back();
+}
+
+// A loop can stop scanning once offset + count of its rows have passed one of
+// its own LIMITs. A LIMIT after any other pipeline breaker sees a grouped,
+// reordered or already emitted stream, and one after a nested FOR counts
+// joined rows rather than this loop's rows, so those bound nothing here.
+// Nested loops get their own bound.
+static void planLimits(ForNode* node) {
+    int stopAfter = -1;
+    bool counted = true;
+    if (node->getAction() != nullptr) {
+        for (auto action : ((ActionNode*)node->getAction())->getActions()) {
+            NodeType type = action->getNodeType();
+            if (type == FOR_NODE) {
+                planLimits((ForNode*)action);
+                counted = false;
+            } else if (type == LIMIT_NODE) {
+                LimitNode* limit = (LimitNode*)action;
+                int bound = std::max(limit->getOffset(), 0) + std::max(limit->getCount(), 0);
+                if (counted && (stopAfter < 0 || bound < stopAfter)) {
+                    stopAfter = bound;
+                }
+            } else if (isPipelineBreaker(action)) {
+                counted = false;
+            }
+        }
+    }
+    node->setStopAfter(stopAfter);
+}
+
+// Gathers every reference read anywhere below node. UPDATE and REMOVE only
+// address the row itself, so their loop variable does not count as a read.
+static void collectRefs(Node* node, std::list<std::string>& refs) {
+    if (node == nullptr) {
+        return;
+    }
+    switch (node->getNodeType()) {
+        case CONSTANT_NODE:
+            if (((Constant*)node)->getType() == REF) {
+                refs.push_back(((Constant*)node)->getStrVal());
+            }
+            break;
+        case FOR_NODE:
+            collectRefs(((ForNode*)node)->getAction(), refs);
+            break;
+        case ACTION_NODE:
+            for (auto action : ((ActionNode*)node)->getActions()) {
+                collectRefs(action, refs);
+            }
+            break;
+        case FILTER_NODE:
+            collectRefs(((FilterNode*)node)->getPredicate(), refs);
+            break;
+        case CONDITION_NODE:
+            collectRefs(((Condition*)node)->getLeft(), refs);
+            collectRefs(((Condition*)node)->getRight(), refs);
+            break;
+        case CONDITION_UNION_NODE:
+            for (auto operand : ((ConditionUnion*)node)->getOperands()) {
+                collectRefs(operand, refs);
+            }
+            break;
+        case CONDITION_IN_NODE:
+            collectRefs(((InCondition*)node)->getValue(), refs);
+            break;
+        case RETURN_NODE:
+            collectRefs(((ReturnAction*)node)->getValue(), refs);
+            break;
+        case UPDATE_NODE:
+            collectRefs(((UpdateAction*)node)->getValue(), refs);
+            break;
+        case MAP_NODE:
+            for (auto entry : ((MapNode*)node)->getEntries()) {
+                collectRefs(entry->getValue(), refs);
+            }
+            break;
+        case SORT_NODE:
+            for (auto key : ((SortNode*)node)->getKeys()) {
+                collectRefs(key.value, refs);
+            }
+            break;
+        case COLLECT_NODE:
+            for (auto group : ((CollectNode*)node)->getGroups()) {
+                collectRefs(group.value, refs);
+            }
+            for (auto aggregate : ((CollectNode*)node)->getAggregates()) {
+                collectRefs(aggregate.argument, refs);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Limits each scan to the top-level fields of its loop variable that the
+// query reads. A bare `x` anywhere means whole documents are needed.
+static void planProjections(ForNode* node) {
+    std::list<std::string> refs;
+    collectRefs(node, refs);
+
+    std::string variable = node->getVariable();
+    std::set<std::string> fields;
+    bool wholeDocument = false;
+    for (auto& ref : refs) {
+        if (ref == variable) {
+            wholeDocument = true;
+        } else if (ref.compare(0, variable.size() + 1, variable + ".") == 0) {
+            std::string path = ref.substr(variable.size() + 1);
+            fields.insert(path.substr(0, path.find('.')));
+        }
+    }
+    node->setProjection(fields, wholeDocument);
+
+    if (node->getAction() == nullptr) {
+        return;
+    }
+    for (auto action : ((ActionNode*)node->getAction())->getActions()) {
+        if (action->getNodeType() == FOR_NODE) {
+            planProjections((ForNode*)action);
+        }
+    }
+}
+
+// A condition can run in an enclosing loop when every reference in it is
+// bound by one of the loops above node.
+static bool canLiftCondition(Predicate* predicate, ForNode* node, std::list<ForNode*>& outer) {
+    std::list<std::string> refs;
+    collectRefs(predicate, refs);
+    for (auto& ref : refs) {
+        std::string variable = ref.substr(0, ref.find('.'));
+        if (variable == node->getVariable() || findLoop(outer, variable) == nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Takes the conjuncts of filter that can be lifted out of node. Returns false
+// when nothing of the filter is left and it should be removed.
+static bool liftConditions(FilterNode* filter, ForNode* node, std::list<ForNode*>& outer, std::list<Predicate*>& lifted) {
+    Predicate* predicate = filter->getPredicate();
+    if (predicate->getNodeType() != CONDITION_UNION_NODE || ((ConditionUnion*)predicate)->getOperator() != AND) {
+        if (!canLiftCondition(predicate, node, outer)) {
+            return true;
+        }
+        lifted.push_back(predicate);
+        filter->setPredicate(nullptr);
+        return false;
+    }
+
+    std::list<Predicate*>& operands = ((ConditionUnion*)predicate)->getOperands();
+    for (auto it = operands.begin(); it != operands.end();) {
+        if (canLiftCondition(*it, node, outer)) {
+            lifted.push_back(*it);
+            it = operands.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (operands.empty()) {
+        return false;
+    }
+    if (operands.size() == 1) {
+        filter->setPredicate(operands.front());
+        operands.clear();
+        delete predicate;
+    }
+    return true;
+}
+
+// Moves each FILTER condition up to the outermost loop where all of its
+// references are bound, so it runs once per outer row instead of once per
+// inner row. Conditions never move past a pipeline breaker. Conditions that
+// can go higher than node are returned in lifted.
+static void pushDownFilters(ForNode* node, std::list<ForNode*>& outer, std::list<Predicate*>& lifted) {
+    if (node->getAction() == nullptr) {
+        return;
+    }
+    std::list<Node*>& actions = ((ActionNode*)node->getAction())->getActions();
+    bool blocked = false;
+    for (auto it = actions.begin(); it != actions.end();) {
+        NodeType type = (*it)->getNodeType();
+        if (isPipelineBreaker(*it)) {
+            blocked = true;
+        } else if (type == FILTER_NODE && !blocked && !outer.empty()) {
+            if (!liftConditions((FilterNode*)*it, node, outer, lifted)) {
+                delete *it;
+                it = actions.erase(it);
+                continue;
+            }
+        } else if (type == FOR_NODE) {
+            std::list<Predicate*> fromInner;
+            outer.push_back(node);
+            pushDownFilters((ForNode*)*it, outer, fromInner);
+            outer.pop_back();
+
+            Predicate* here = nullptr;
+            for (auto predicate : fromInner) {
+                if (!blocked && !outer.empty() && canLiftCondition(predicate, node, outer)) {
+                    lifted.push_back(predicate);
+                } else {
+                    here = here == nullptr ? predicate : ConditionUnion::combine(AND, here, predicate);
+                }
+            }
+            if (here != nullptr) {
+                actions.insert(it, new FilterNode(here));
+            }
+        }
+        ++it;
+    }
+}
+
+void planQuery(Node* query, Catalog& catalog) {
+    if (query->getNodeType() == FOR_NODE) {
+        std::list<ForNode*> outer;
+        std::list<Predicate*> lifted;
+        pushDownFilters((ForNode*)query, outer, lifted);
+        planFor((ForNode*)query, outer, catalog);
+        planLimits((ForNode*)query);
+        planProjections((ForNode*)query);
+    }
+}
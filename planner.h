@@ -0,0 +1,75 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+
+// Rows per storage block; zone maps and other block statistics cover this many rows.
+const size_t blockRows = 1024;
+
+// Range of the numeric values a block holds for one field, and how many of
+// its values are strings, which compare above every number.
+struct FieldZone {
+    double min = 0;
+    double max = 0;
+    size_t values = 0;
+    size_t strings = 0;
+};
+
+// Set of the values a block holds for one field, with false positives.
+class BloomFilter {
+    private:
+        std::vector<uint64_t> bits;
+    public:
+        BloomFilter();
+        void add(const std::string& key);
+        bool mayContain(const std::string& key);
+};
+
+// Distinct string values of one field in a block. Dropped once the field
+// gets too many distinct values or a non-string value.
+struct Dictionary {
+    std::unordered_set<std::string> distinct;
+    size_t values = 0;
+    bool overflow = false;
+};
+
+struct BlockStats {
+    size_t rows = 0;
+    std::unordered_map<std::string, FieldZone> zones;
+    std::unordered_map<std::string, BloomFilter> blooms;
+    std::unordered_map<std::string, Dictionary> dictionaries;
+    // Fields an UPDATE has written since their statistics were gathered.
+    // Nothing is known about them, not even whether they are absent.
+    std::unordered_set<std::string> unknownFields;
+};
+
+struct TableStats {
+    size_t rows = 0;
+    std::vector<BlockStats> blocks;
+    std::unordered_set<std::string> indexes;
+    // Numeric fields whose inserted values have never decreased.
+    std::unordered_set<std::string> sortedFields;
+    std::unordered_map<std::string, double> lastValues;
+    // Field types declared in CREATE TABLE.
+    std::unordered_map<std::string, DataType> fieldTypes;
+};
+
+// Tables known to the session, kept up to date from CREATE/INSERT/UPDATE/DROP queries.
+class Catalog {
+    private:
+        std::unordered_map<std::string, TableStats> tables;
+
+        void applyUpdates(ForNode* loop);
+    public:
+        void apply(Node* query);
+        TableStats* find(const char* table);
+};
+
+void planQuery(Node* query, Catalog& catalog);
+
+#endif